@@ -0,0 +1,620 @@
+#pragma once
+ 
+#include "graph.h"
+#include "router.h"
+ 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+ 
+namespace graph {
+ 
+template <typename Weight>
+class ContractionHierarchyRouter {
+using Graph = DirectedWeightedGraph<Weight>;
+ 
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+    
+    // hierarchy edges [0, E) are the graph's own edges, edge E + i is the shortcut
+    // shortcut_first_edges[i] followed by shortcut_second_edges[i]
+    struct HierarchyInternalData {
+        std::vector<uint32_t> ranks;
+        std::vector<uint32_t> shortcut_first_edges;
+        std::vector<uint32_t> shortcut_second_edges;
+    };
+    
+    explicit ContractionHierarchyRouter(const Graph& graph);
+    ContractionHierarchyRouter(const Graph& graph, HierarchyInternalData hierarchy_internal_data);
+    
+    std::optional<RouteInfo> Build_route(VertexId from, VertexId to) const;
+    
+    // the upward search from `from` is shared by every target;
+    // both are safe to call from several threads, each thread searches in its own buffers
+    std::vector<std::optional<RouteInfo>> Build_routes(VertexId from, const std::vector<VertexId>& to) const;
+    
+    const HierarchyInternalData& GetHierarchyInternalData() const;
+ 
+private:
+    using HeapItem = std::pair<Weight, VertexId>;
+    
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        uint32_t first_edge;
+        uint32_t second_edge;
+    };
+    
+    // a live arc of the graph being contracted, only the lightest one per vertex pair is kept
+    struct Arc {
+        VertexId vertex;
+        uint32_t edge;
+    };
+    
+    struct SearchSpace {
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+        std::vector<VertexId> touched_vertices;
+        std::vector<HeapItem> heap;
+    };
+    
+    struct SearchState {
+        SearchSpace forward;
+        SearchSpace backward;
+    };
+    
+    // the graph still being contracted and the scratch buffers of the witness searches
+    struct ContractionState {
+        std::vector<std::vector<Arc>> outs;
+        std::vector<std::vector<Arc>> ins;
+        SearchSpace witness;
+        std::vector<uint32_t> arc_positions;
+        std::vector<bool> is_target;
+    };
+    
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::max();
+    static constexpr uint32_t NONE_EDGE = std::numeric_limits<uint32_t>::max();
+    static constexpr size_t WITNESS_SETTLED_LIMIT = 64;
+    static constexpr size_t SIMULATION_SETTLED_LIMIT = 4;
+    
+    void Build();
+    
+    // returns the number of shortcuts the contraction needs, adds them unless simulate is set
+    size_t Contract(VertexId vertex, ContractionState& state, bool simulate);
+    void WitnessSearch(VertexId from, VertexId skipped, Weight max_weight, size_t targets_count, size_t settled_limit,
+                       ContractionState& state) const;
+    
+    // AddArc expects the arcs leaving `from` to be indexed
+    void IndexArcs(VertexId from, ContractionState& state) const;
+    void UnindexArcs(VertexId from, ContractionState& state) const;
+    void AddArc(VertexId from, VertexId to, uint32_t edge, ContractionState& state) const;
+    
+    void AddShortcut(uint32_t first_edge, uint32_t second_edge);
+    void BuildSearchGraph();
+    
+    SearchSpace MakeSearchSpace() const;
+    // the calling thread's buffers, reused by every query of the thread on a graph of this size
+    SearchState& GetSearchState() const;
+    void ResetSearchSpace(SearchSpace& space) const;
+    void UpwardSearch(VertexId from, bool forward, SearchSpace& space) const;
+    
+    std::optional<RouteInfo> Query(VertexId to, SearchState& state) const;
+    void UnpackEdge(uint32_t edge, std::vector<EdgeId>& edges) const;
+    
+    const Graph& graph_;
+    HierarchyInternalData hierarchy_internal_data_;
+    std::vector<HierarchyEdge> edges_;
+    
+    // upward edges by tail vertex for the forward search, by head vertex for the backward one
+    std::vector<uint32_t> up_offsets_;
+    std::vector<uint32_t> up_edges_;
+    std::vector<uint32_t> down_offsets_;
+    std::vector<uint32_t> down_edges_;
+};
+ 
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph) : graph_(graph) {
+ 
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        
+        edges_.push_back({edge.from, edge.to, edge.weight, NONE_EDGE, NONE_EDGE});
+    }
+    
+    Build();
+    BuildSearchGraph();
+}
+ 
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, HierarchyInternalData hierarchy_internal_data)
+    : graph_(graph) {
+    
+    if (hierarchy_internal_data.ranks.size() != graph.GetVertexCount()
+        || hierarchy_internal_data.shortcut_first_edges.size() != hierarchy_internal_data.shortcut_second_edges.size()) {
+        
+        throw std::invalid_argument("hierarchy internal data does not match the graph");
+    }
+    
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        edges_.push_back({edge.from, edge.to, edge.weight, NONE_EDGE, NONE_EDGE});
+    }
+    
+    hierarchy_internal_data_.ranks = std::move(hierarchy_internal_data.ranks);
+    
+    for (size_t i = 0; i < hierarchy_internal_data.shortcut_first_edges.size(); ++i) {
+        const uint32_t first_edge = hierarchy_internal_data.shortcut_first_edges[i];
+        const uint32_t second_edge = hierarchy_internal_data.shortcut_second_edges[i];
+        
+        if (first_edge >= edges_.size() || second_edge >= edges_.size()) {
+            throw std::invalid_argument("shortcut refers to an unknown edge");
+        }
+        
+        AddShortcut(first_edge, second_edge);
+    }
+    
+    BuildSearchGraph();
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::IndexArcs(VertexId from, ContractionState& state) const {
+    const auto& outs = state.outs[from];
+    
+    for (uint32_t position = 0; position < outs.size(); ++position) {
+        state.arc_positions[outs[position].vertex] = position;
+    }
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnindexArcs(VertexId from, ContractionState& state) const {
+    
+    for (const Arc& arc : state.outs[from]) {
+        state.arc_positions[arc.vertex] = NONE_EDGE;
+    }
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::AddArc(VertexId from, VertexId to, uint32_t edge, ContractionState& state) const {
+    uint32_t& position = state.arc_positions[to];
+    
+    if (position == NONE_EDGE) {
+        position = state.outs[from].size();
+        state.outs[from].push_back({to, edge});
+        state.ins[to].push_back({from, edge});
+        return;
+    }
+    
+    Arc& arc = state.outs[from][position];
+    
+    if (edges_[edge].weight < edges_[arc.edge].weight) {
+        arc.edge = edge;
+        std::find_if(state.ins[to].begin(), state.ins[to].end(), [from](const Arc& in) {return in.vertex == from;})->edge = edge;
+    }
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::AddShortcut(uint32_t first_edge, uint32_t second_edge) {
+    edges_.push_back({edges_[first_edge].from,
+                      edges_[second_edge].to,
+                      edges_[first_edge].weight + edges_[second_edge].weight,
+                      first_edge,
+                      second_edge});
+    
+    hierarchy_internal_data_.shortcut_first_edges.push_back(first_edge);
+    hierarchy_internal_data_.shortcut_second_edges.push_back(second_edge);
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::WitnessSearch(VertexId from, VertexId skipped, Weight max_weight, 
+                                                       size_t targets_count, size_t settled_limit, 
+                                                       ContractionState& state) const {
+    auto& witness = state.witness;
+    auto& weights = witness.weights;
+    auto& heap = witness.heap;
+    
+    ResetSearchSpace(witness);
+    
+    weights[from] = ZERO_WEIGHT;
+    witness.touched_vertices.push_back(from);
+    heap.push_back({ZERO_WEIGHT, from});
+    
+    for (size_t settled_count = 0; !heap.empty() && settled_count < settled_limit;) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+        const auto [weight, vertex] = heap.back();
+        heap.pop_back();
+        
+        if (weight > weights[vertex]) {
+            continue;
+        }
+        
+        if (state.is_target[vertex] && --targets_count == 0) {
+            return;
+        }
+        
+        ++settled_count;
+        
+        for (const Arc& arc : state.outs[vertex]) {
+        
+            if (arc.vertex == skipped) {
+                continue;
+            }
+            
+            const Weight candidate_weight = weight + edges_[arc.edge].weight;
+            
+            if (candidate_weight < weights[arc.vertex] && candidate_weight <= max_weight) {
+            
+                if (weights[arc.vertex] == INFINITE_WEIGHT) {
+                    witness.touched_vertices.push_back(arc.vertex);
+                }
+                
+                weights[arc.vertex] = candidate_weight;
+                heap.push_back({candidate_weight, arc.vertex});
+                std::push_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+            }
+        }
+    }
+}
+ 
+template <typename Weight>
+size_t ContractionHierarchyRouter<Weight>::Contract(VertexId vertex, ContractionState& state, bool simulate) {
+    size_t shortcuts_count = 0;
+    
+    // the arc lists of the neighbours change while shortcuts are added
+    const std::vector<Arc> vertex_ins = state.ins[vertex];
+    const std::vector<Arc> vertex_outs = state.outs[vertex];
+    
+    Weight max_out_weight = ZERO_WEIGHT;
+    size_t targets_count = 0;
+    
+    // a target entered only from the contracted vertex has no witness
+    for (const Arc& out : vertex_outs) {
+        max_out_weight = std::max(max_out_weight, edges_[out.edge].weight);
+        
+        if (state.ins[out.vertex].size() > 1) {
+            state.is_target[out.vertex] = true;
+            ++targets_count;
+        }
+    }
+    
+    for (const Arc& in : vertex_ins) {
+        
+        if (targets_count > 0) {
+            WitnessSearch(in.vertex, vertex, edges_[in.edge].weight + max_out_weight, targets_count, 
+                          simulate ? SIMULATION_SETTLED_LIMIT : WITNESS_SETTLED_LIMIT, state);
+        } else {
+            ResetSearchSpace(state.witness);
+        }
+        
+        if (!simulate) {
+            IndexArcs(in.vertex, state);
+        }
+        
+        for (const Arc& out : vertex_outs) {
+        
+            if (out.vertex == in.vertex) {
+                continue;
+            }
+            
+            if (state.witness.weights[out.vertex] <= edges_[in.edge].weight + edges_[out.edge].weight) {
+                continue;
+            }
+            
+            ++shortcuts_count;
+            
+            if (!simulate) {
+                AddShortcut(in.edge, out.edge);
+                AddArc(in.vertex, out.vertex, edges_.size() - 1, state);
+            }
+        }
+        
+        if (!simulate) {
+            UnindexArcs(in.vertex, state);
+        }
+    }
+    
+    for (const Arc& out : vertex_outs) {
+        state.is_target[out.vertex] = false;
+    }
+    
+    return shortcuts_count;
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::Build() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    
+    ContractionState state{std::vector<std::vector<Arc>>(vertex_count), 
+                           std::vector<std::vector<Arc>>(vertex_count), 
+                           MakeSearchSpace(), 
+                           std::vector<uint32_t>(vertex_count, NONE_EDGE), 
+                           std::vector<bool>(vertex_count, false)};
+    
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        
+        for (const EdgeId edge : graph_.GetIncidentEdges(vertex)) {
+        
+            if (edges_[edge].to != vertex) {
+                AddArc(vertex, edges_[edge].to, edge, state);
+            }
+        }
+        
+        UnindexArcs(vertex, state);
+    }
+    
+    std::vector<int64_t> contracted_neighbours(vertex_count, 0);
+    
+    // edge difference plus the number of already contracted neighbours
+    auto get_priority = [&](VertexId vertex) {
+        return static_cast<int64_t>(Contract(vertex, state, true))
+               - static_cast<int64_t>(state.outs[vertex].size() + state.ins[vertex].size())
+               + contracted_neighbours[vertex];
+    };
+    
+    using QueueItem = std::pair<int64_t, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.push({get_priority(vertex), vertex});
+    }
+    
+    hierarchy_internal_data_.ranks.assign(vertex_count, 0);
+    uint32_t rank = 0;
+    
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        
+        const int64_t priority = get_priority(vertex);
+        if (!queue.empty() && priority > queue.top().first) {
+            queue.push({priority, vertex});
+            continue;
+        }
+        
+        Contract(vertex, state, false);
+        hierarchy_internal_data_.ranks[vertex] = rank++;
+        
+        auto is_contracted = [vertex](const Arc& arc) {return arc.vertex == vertex;};
+        
+        for (const Arc& in : state.ins[vertex]) {
+            auto& in_outs = state.outs[in.vertex];
+            in_outs.erase(std::remove_if(in_outs.begin(), in_outs.end(), is_contracted), in_outs.end());
+            ++contracted_neighbours[in.vertex];
+        }
+        
+        for (const Arc& out : state.outs[vertex]) {
+            auto& out_ins = state.ins[out.vertex];
+            out_ins.erase(std::remove_if(out_ins.begin(), out_ins.end(), is_contracted), out_ins.end());
+            ++contracted_neighbours[out.vertex];
+        }
+        
+        state.outs[vertex].clear();
+        state.ins[vertex].clear();
+    }
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::BuildSearchGraph() {
+    const auto& ranks = hierarchy_internal_data_.ranks;
+    const size_t vertex_count = graph_.GetVertexCount();
+    
+    up_offsets_.assign(vertex_count + 1, 0);
+    down_offsets_.assign(vertex_count + 1, 0);
+    
+    for (const auto& edge : edges_) {
+    
+        if (ranks[edge.from] < ranks[edge.to]) {
+            ++up_offsets_[edge.from + 1];
+        } else if (ranks[edge.from] > ranks[edge.to]) {
+            ++down_offsets_[edge.to + 1];
+        }
+    }
+    
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        up_offsets_[vertex + 1] += up_offsets_[vertex];
+        down_offsets_[vertex + 1] += down_offsets_[vertex];
+    }
+    
+    up_edges_.resize(up_offsets_.back());
+    down_edges_.resize(down_offsets_.back());
+    
+    std::vector<uint32_t> up_fill(up_offsets_.begin(), std::prev(up_offsets_.end()));
+    std::vector<uint32_t> down_fill(down_offsets_.begin(), std::prev(down_offsets_.end()));
+    
+    for (uint32_t edge = 0; edge < edges_.size(); ++edge) {
+        const auto& hierarchy_edge = edges_[edge];
+        
+        if (ranks[hierarchy_edge.from] < ranks[hierarchy_edge.to]) {
+            up_edges_[up_fill[hierarchy_edge.from]++] = edge;
+        } else if (ranks[hierarchy_edge.from] > ranks[hierarchy_edge.to]) {
+            down_edges_[down_fill[hierarchy_edge.to]++] = edge;
+        }
+    }
+}
+ 
+template <typename Weight>
+typename ContractionHierarchyRouter<Weight>::SearchSpace ContractionHierarchyRouter<Weight>::MakeSearchSpace() const {
+    return {std::vector<Weight>(graph_.GetVertexCount(), INFINITE_WEIGHT),
+            std::vector<uint32_t>(graph_.GetVertexCount(), NONE_EDGE),
+            {},
+            {}};
+}
+ 
+template <typename Weight>
+typename ContractionHierarchyRouter<Weight>::SearchState& ContractionHierarchyRouter<Weight>::GetSearchState() const {
+    thread_local SearchState state;
+    
+    // every search resets its space first, the buffers only follow the graph size
+    if (state.forward.weights.size() != graph_.GetVertexCount()) {
+        state = {MakeSearchSpace(), MakeSearchSpace()};
+    }
+    
+    return state;
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::ResetSearchSpace(SearchSpace& space) const {
+ 
+    for (const VertexId vertex : space.touched_vertices) {
+        space.weights[vertex] = INFINITE_WEIGHT;
+        space.prev_edges[vertex] = NONE_EDGE;
+    }
+    
+    space.touched_vertices.clear();
+    space.heap.clear();
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UpwardSearch(VertexId from, bool forward, SearchSpace& space) const {
+    const auto& offsets = forward ? up_offsets_ : down_offsets_;
+    const auto& search_edges = forward ? up_edges_ : down_edges_;
+    
+    auto& weights = space.weights;
+    auto& heap = space.heap;
+    
+    ResetSearchSpace(space);
+    
+    weights[from] = ZERO_WEIGHT;
+    space.touched_vertices.push_back(from);
+    heap.push_back({ZERO_WEIGHT, from});
+    
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+        const auto [weight, vertex] = heap.back();
+        heap.pop_back();
+        
+        if (weight > weights[vertex]) {
+            continue;
+        }
+        
+        for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const auto& edge = edges_[search_edges[i]];
+            const VertexId next_vertex = forward ? edge.to : edge.from;
+            const Weight candidate_weight = weight + edge.weight;
+            
+            if (candidate_weight < weights[next_vertex]) {
+            
+                if (weights[next_vertex] == INFINITE_WEIGHT) {
+                    space.touched_vertices.push_back(next_vertex);
+                }
+                
+                weights[next_vertex] = candidate_weight;
+                space.prev_edges[next_vertex] = search_edges[i];
+                
+                heap.push_back({candidate_weight, next_vertex});
+                std::push_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+            }
+        }
+    }
+}
+ 
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(uint32_t edge, std::vector<EdgeId>& edges) const {
+    std::vector<uint32_t> stack{edge};
+    
+    while (!stack.empty()) {
+        const auto& hierarchy_edge = edges_[stack.back()];
+        
+        if (hierarchy_edge.first_edge == NONE_EDGE) {
+            edges.push_back(stack.back());
+            stack.pop_back();
+        } else {
+            stack.back() = hierarchy_edge.second_edge;
+            stack.push_back(hierarchy_edge.first_edge);
+        }
+    }
+}
+ 
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo> ContractionHierarchyRouter<Weight>::Query(VertexId to,
+                                                                                                               SearchState& state) const {
+    UpwardSearch(to, false, state.backward);
+    
+    const auto& forward_weights = state.forward.weights;
+    const auto& backward_weights = state.backward.weights;
+    
+    Weight weight = INFINITE_WEIGHT;
+    VertexId meeting_vertex = 0;
+    
+    for (const VertexId vertex : state.backward.touched_vertices) {
+    
+        if (forward_weights[vertex] != INFINITE_WEIGHT && forward_weights[vertex] + backward_weights[vertex] < weight) {
+            weight = forward_weights[vertex] + backward_weights[vertex];
+            meeting_vertex = vertex;
+        }
+    }
+    
+    if (weight == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    
+    std::vector<uint32_t> hierarchy_edges;
+    for (uint32_t edge = state.forward.prev_edges[meeting_vertex]; edge != NONE_EDGE; edge = state.forward.prev_edges[edges_[edge].from]) {
+        hierarchy_edges.push_back(edge);
+    }
+    
+    std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+    
+    for (uint32_t edge = state.backward.prev_edges[meeting_vertex]; edge != NONE_EDGE; edge = state.backward.prev_edges[edges_[edge].to]) {
+        hierarchy_edges.push_back(edge);
+    }
+    
+    std::vector<EdgeId> edges;
+    for (const uint32_t edge : hierarchy_edges) {
+        UnpackEdge(edge, edges);
+    }
+    
+    return RouteInfo{weight, std::move(edges)};
+}
+ 
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo> ContractionHierarchyRouter<Weight>::Build_route(VertexId from,
+                                                                                                                     VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("vertex is out of the graph");
+    }
+    
+    SearchState& state = GetSearchState();
+    UpwardSearch(from, true, state.forward);
+    
+    return Query(to, state);
+}
+ 
+template <typename Weight>
+std::vector<std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>> ContractionHierarchyRouter<Weight>::Build_routes(VertexId from,
+                                                                                                                                   const std::vector<VertexId>& to) const {
+    SearchState& state = GetSearchState();
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(to.size());
+    
+    UpwardSearch(from, true, state.forward);
+    
+    for (const VertexId vertex : to) {
+    
+        if (vertex >= graph_.GetVertexCount()) {
+            throw std::out_of_range("vertex is out of the graph");
+        }
+        
+        routes.push_back(Query(vertex, state));
+    }
+    
+    return routes;
+}
+ 
+template <typename Weight>
+const typename ContractionHierarchyRouter<Weight>::HierarchyInternalData& ContractionHierarchyRouter<Weight>::GetHierarchyInternalData() const {
+    return hierarchy_internal_data_;
+}
+ 
+} // namespace graph
@@ -0,0 +1,214 @@
+#pragma once
+ 
+#include "graph.h"
+#include "router.h"
+ 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+ 
+namespace graph {
+ 
+template <typename Weight>
+class DijkstraRouter {
+using Graph = DirectedWeightedGraph<Weight>;
+ 
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+    
+    explicit DijkstraRouter(const Graph& graph);
+    
+    std::optional<RouteInfo> Build_route(VertexId from, VertexId to) const;
+    
+    // one shortest-path tree from `from` answers every target;
+    // both are safe to call from several threads, each thread searches in its own buffers
+    std::vector<std::optional<RouteInfo>> Build_routes(VertexId from, const std::vector<VertexId>& to) const;
+ 
+private:
+    using HeapItem = std::pair<Weight, VertexId>;
+    
+    // label buffers of one search, only the touched vertices are reset before the next one
+    struct SearchState {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<bool> is_target;
+        std::vector<VertexId> touched_vertices;
+        std::vector<HeapItem> heap;
+    };
+    
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::max();
+    static constexpr EdgeId NONE_EDGE = std::numeric_limits<EdgeId>::max();
+    
+    // the calling thread's buffers, reused by every search of the thread on a graph of this size
+    SearchState& GetSearchState() const;
+    void ResetLabels(SearchState& state) const;
+    
+    template <typename IsTarget>
+    void Search(VertexId from, size_t targets_count, IsTarget is_target, SearchState& state) const;
+    
+    std::optional<RouteInfo> ExtractRoute(VertexId to, const SearchState& state) const;
+    
+    const Graph& graph_;
+};
+ 
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph) : graph_(graph) {
+    
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+ 
+template <typename Weight>
+typename DijkstraRouter<Weight>::SearchState& DijkstraRouter<Weight>::GetSearchState() const {
+    thread_local SearchState state;
+    
+    // labels are reset before each search, the buffers only follow the graph size
+    if (state.weights.size() != graph_.GetVertexCount()) {
+        state = {std::vector<Weight>(graph_.GetVertexCount(), INFINITE_WEIGHT), 
+                 std::vector<EdgeId>(graph_.GetVertexCount(), NONE_EDGE), 
+                 std::vector<bool>(graph_.GetVertexCount(), false), 
+                 {}, 
+                 {}};
+    }
+    
+    return state;
+}
+ 
+template <typename Weight>
+void DijkstraRouter<Weight>::ResetLabels(SearchState& state) const {
+    
+    for (const VertexId vertex : state.touched_vertices) {
+        state.weights[vertex] = INFINITE_WEIGHT;
+        state.prev_edges[vertex] = NONE_EDGE;
+    }
+    
+    state.touched_vertices.clear();
+    state.heap.clear();
+}
+ 
+template <typename Weight>
+template <typename IsTarget>
+void DijkstraRouter<Weight>::Search(VertexId from, size_t targets_count, IsTarget is_target, SearchState& state) const {
+    auto& weights = state.weights;
+    auto& heap = state.heap;
+    
+    weights[from] = ZERO_WEIGHT;
+    state.touched_vertices.push_back(from);
+    heap.push_back({ZERO_WEIGHT, from});
+    
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+        const auto [weight, vertex] = heap.back();
+        heap.pop_back();
+        
+        if (weight > weights[vertex]) {
+            continue;
+        }
+        
+        if (is_target(vertex) && --targets_count == 0) {
+            return;
+        }
+        
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            
+            if (candidate_weight < weights[edge.to]) {
+            
+                if (weights[edge.to] == INFINITE_WEIGHT) {
+                    state.touched_vertices.push_back(edge.to);
+                }
+                
+                weights[edge.to] = candidate_weight;
+                state.prev_edges[edge.to] = edge_id;
+                
+                heap.push_back({candidate_weight, edge.to});
+                std::push_heap(heap.begin(), heap.end(), std::greater<HeapItem>{});
+            }
+        }
+    }
+}
+ 
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::ExtractRoute(VertexId to, 
+                                                                                               const SearchState& state) const {
+    if (state.weights[to] == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = state.prev_edges[to];
+         edge_id != NONE_EDGE;
+         edge_id = state.prev_edges[graph_.GetEdge(edge_id).from]) {
+        
+        edges.push_back(edge_id);
+    }
+    
+    std::reverse(edges.begin(), edges.end());
+    
+    return RouteInfo{state.weights[to], std::move(edges)};
+}
+ 
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::Build_route(VertexId from,
+                                                                                              VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("unknown route vertex");
+    }
+    
+    SearchState& state = GetSearchState();
+    
+    ResetLabels(state);
+    Search(from, 1, [to](VertexId vertex) {return vertex == to;}, state);
+    
+    return ExtractRoute(to, state);
+}
+ 
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::Build_routes(VertexId from, 
+                                                                                                            const std::vector<VertexId>& to) const {
+    SearchState& state = GetSearchState();
+    auto& is_target = state.is_target;
+    size_t targets_count = 0;
+    
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("unknown route vertex");
+    }
+    
+    // checked before marking, so an unknown vertex leaves no marks behind
+    for (const VertexId vertex : to) {
+        if (vertex >= graph_.GetVertexCount()) {
+            throw std::out_of_range("unknown target vertex");
+        }
+    }
+    
+    for (const VertexId vertex : to) {
+        if (!is_target[vertex]) {
+            is_target[vertex] = true;
+            ++targets_count;
+        }
+    }
+    
+    ResetLabels(state);
+    Search(from, targets_count, [&is_target](VertexId vertex) {return is_target[vertex];}, state);
+    
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(to.size());
+    
+    for (const VertexId vertex : to) {
+        routes.push_back(ExtractRoute(vertex, state));
+        is_target[vertex] = false;
+    }
+    
+    return routes;
+}
+ 
+} // namespace graph
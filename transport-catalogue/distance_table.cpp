@@ -0,0 +1,138 @@
+#include "distance_table.h"
+ 
+#include <algorithm>
+ 
+namespace transport_catalogue {
+ 
+domain::Distance DistanceTable::ConstIterator::operator*() const {
+    const Slot& slot = (*slots_)[position_ / 2];
+    const domain::StopId low = static_cast<domain::StopId>(slot.key >> 32);
+    const domain::StopId high = static_cast<domain::StopId>(slot.key);
+    
+    if (position_ % 2 == 0) {
+        return {low, high, slot.forward};
+    } else {
+        return {high, low, slot.backward};
+    }
+}
+ 
+void DistanceTable::ConstIterator::SkipAbsent() {
+ 
+    for (; position_ < 2 * slots_->size(); ++position_) {
+        const Slot& slot = (*slots_)[position_ / 2];
+        
+        if (slot.key != EMPTY_KEY && (position_ % 2 == 0 ? slot.forward : slot.backward) != NO_DISTANCE) {
+            return;
+        }
+    }
+}
+ 
+DistanceTable::DistanceTable() : slots_(std::vector<Slot>(INITIAL_CAPACITY, Slot{EMPTY_KEY, NO_DISTANCE, NO_DISTANCE})) {}
+ 
+DistanceTable::DistanceTable(Table<Slot>&& slots, size_t used_slots, size_t size) : slots_(std::move(slots))
+                                                                                  , used_slots_(used_slots)
+                                                                                  , size_(size) {}
+ 
+void DistanceTable::Insert(domain::StopId from, domain::StopId to, int distance) {
+ 
+    if (2 * (used_slots_ + 1) > slots_.size()) {
+        Grow();
+    }
+    
+    const uint64_t key = PackKey(from, to);
+    Slot& slot = slots_.MutableData()[FindSlot(key)];
+    
+    if (slot.key == EMPTY_KEY) {
+        slot.key = key;
+        ++used_slots_;
+    }
+    
+    int& stored = from <= to ? slot.forward : slot.backward;
+    
+    if (stored == NO_DISTANCE) {
+        stored = distance;
+        ++size_;
+    }
+}
+ 
+std::optional<int> DistanceTable::Find(domain::StopId from, domain::StopId to) const {
+    const Slot& slot = slots_[FindSlot(PackKey(from, to))];
+    
+    if (slot.key == EMPTY_KEY) {
+        return std::nullopt;
+    }
+    
+    const int direct = from <= to ? slot.forward : slot.backward;
+    const int reverse = from <= to ? slot.backward : slot.forward;
+    
+    if (direct != NO_DISTANCE) {
+        return direct;
+    } else if (reverse != NO_DISTANCE) {
+        return reverse;
+    } else {
+        return std::nullopt;
+    }
+}
+ 
+size_t DistanceTable::size() const {
+    return size_;
+}
+ 
+bool DistanceTable::empty() const {
+    return size_ == 0;
+}
+ 
+DistanceTable::ConstIterator DistanceTable::begin() const {
+    return ConstIterator(&slots_, 0);
+}
+ 
+DistanceTable::ConstIterator DistanceTable::end() const {
+    return ConstIterator(&slots_, 2 * slots_.size());
+}
+ 
+const Table<DistanceTable::Slot>& DistanceTable::GetSlots() const {
+    return slots_;
+}
+ 
+size_t DistanceTable::GetUsedSlots() const {
+    return used_slots_;
+}
+ 
+uint64_t DistanceTable::PackKey(domain::StopId from, domain::StopId to) {
+    const auto [low, high] = std::minmax(from, to);
+    return static_cast<uint64_t>(low) << 32 | high;
+}
+ 
+uint64_t DistanceTable::Hash(uint64_t key) {
+    // splitmix64 finalizer
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}
+ 
+size_t DistanceTable::FindSlot(uint64_t key) const {
+    const size_t mask = slots_.size() - 1;
+    
+    for (size_t index = Hash(key) & mask; ; index = (index + 1) & mask) {
+    
+        if (slots_[index].key == key || slots_[index].key == EMPTY_KEY) {
+            return index;
+        }
+    }
+}
+ 
+void DistanceTable::Grow() {
+    Table<Slot> slots = std::vector<Slot>(2 * slots_.size(), Slot{EMPTY_KEY, NO_DISTANCE, NO_DISTANCE});
+    std::swap(slots_, slots);
+    
+    Slot* data = slots_.MutableData();
+    
+    for (const Slot& slot : slots) {
+    
+        if (slot.key != EMPTY_KEY) {
+            data[FindSlot(slot.key)] = slot;
+        }
+    }
+}
+ 
+} // namespace transport_catalogue
@@ -0,0 +1,102 @@
+#pragma once
+ 
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <vector>
+ 
+#include "domain.h"
+#include "table.h"
+ 
+namespace transport_catalogue {
+ 
+// open addressing table of road distances keyed by the packed unordered stop pair,
+// both directions of a pair share one slot, so a lookup with the reverse-direction
+// fallback is a single probe sequence
+class DistanceTable {
+public:
+    // a slot is plain data, so the whole slot array can be saved and loaded as is
+    struct Slot {
+        uint64_t key;
+        int forward;
+        int backward;
+    };
+ 
+    static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+    static constexpr int NO_DISTANCE = std::numeric_limits<int>::min();
+    
+    
+    class ConstIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = domain::Distance;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const domain::Distance*;
+        using reference = domain::Distance;
+        
+        ConstIterator() = default;
+        ConstIterator(const Table<Slot>* slots, size_t position) : slots_(slots)
+                                                                        , position_(position) {
+            SkipAbsent();
+        }
+        
+        domain::Distance operator*() const;
+        
+        ConstIterator& operator++() {
+            ++position_;
+            SkipAbsent();
+            return *this;
+        }
+        
+        ConstIterator operator++(int) {
+            ConstIterator result = *this;
+            ++*this;
+            return result;
+        }
+        
+        bool operator==(const ConstIterator& other) const {return position_ == other.position_;}
+        bool operator!=(const ConstIterator& other) const {return position_ != other.position_;}
+    
+    private:
+        void SkipAbsent();
+        
+        // every slot is visited twice: position 2 * i is its forward direction, 2 * i + 1 the backward one
+        const Table<Slot>* slots_ = nullptr;
+        size_t position_ = 0;
+    };
+    
+    DistanceTable();
+    // takes over a slot array saved from another table together with its counts
+    DistanceTable(Table<Slot>&& slots, size_t used_slots, size_t size);
+    
+    // keeps the distance already stored for the same direction
+    void Insert(domain::StopId from, domain::StopId to, int distance);
+    
+    // distance from -> to, falling back to to -> from when only that one is known
+    std::optional<int> Find(domain::StopId from, domain::StopId to) const;
+    
+    size_t size() const;
+    bool empty() const;
+    
+    ConstIterator begin() const;
+    ConstIterator end() const;
+ 
+    const Table<Slot>& GetSlots() const;
+    size_t GetUsedSlots() const;
+ 
+private:
+    static constexpr size_t INITIAL_CAPACITY = 16;
+    
+    static uint64_t PackKey(domain::StopId from, domain::StopId to);
+    static uint64_t Hash(uint64_t key);
+    
+    size_t FindSlot(uint64_t key) const;
+    void Grow();
+    
+    Table<Slot> slots_;
+    size_t used_slots_ = 0;
+    size_t size_ = 0;
+};
+ 
+} // namespace transport_catalogue
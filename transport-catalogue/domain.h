@@ -1,12 +1,15 @@
 #pragma once
  
 #include <algorithm>
+#include <cstdint>
+#include <optional>
 #include <vector>
 #include <string>
 #include <variant>
  
 #include "geo.h"
 #include "graph.h"
+#include "ranges.h"
  
 namespace domain {
  
@@ -16,31 +19,65 @@ struct StatRequest {
     std::string name;    
     std::string from;
     std::string to;
+    // NearestStops and StopsInRadius
+    geo::Coordinates point = {0., 0.};
+    int count = 0;
+    double radius = 0.;
+    // Suggest
+    std::string prefix;
+    int limit = 0;
 };
     
-struct Bus;
+// dense ids given by the catalogue in insertion order
+using StopId = uint32_t;
+using BusId = uint32_t;
+ 
+using BusIdRange = ranges::Range<const BusId*>;
     
 struct Stop {     
     std::string name;
     double latitude;
     double longitude;
-    
-    std::vector<Bus*> buses;
+};
+ 
+struct BusStats {
+    uint32_t stops_on_route = 0;
+    uint32_t unique_stops = 0;
+    size_t route_length = 0;
+    double geo_length = 0.;
+    double curvature = 0.;
 };
  
 struct Bus {     
     std::string name;
-    std::vector<Stop*> stops;
+    std::vector<StopId> stops;
     bool is_roundtrip;
-    size_t route_length;
+    // computed by the catalogue when not given, e.g. when loaded from a base
+    std::optional<BusStats> stats;
+    // road distance from the first stop to every stop of the route
+    std::vector<size_t> distances;
 };
  
 struct Distance {    
-    const Stop* start;
-    const Stop* end;
+    StopId start;
+    StopId end;
     int distance;
 };  
  
+struct NearbyStop {
+    StopId stop;
+    // metres along the great circle
+    double distance;
+};
+ 
+// a bus going from one stop to another without a transfer
+struct DirectConnection {
+    BusId bus;
+    uint32_t span_count;
+    // road metres
+    size_t distance;
+};
+ 
 struct BusQueryResult {
     std::string_view name;
     bool not_found;
@@ -53,7 +90,8 @@ struct BusQueryResult {
 struct StopQueryResult {
     std::string_view name;
     bool not_found;
-    std::vector<std::string> buses_name;
+    // sorted by bus name
+    BusIdRange buses;
 };
     
 struct StopEdge {
@@ -67,9 +105,35 @@ struct BusEdge {
     double time = 0;
 };
  
+enum class RouterEngine {
+    ALL_PAIRS,
+    DIJKSTRA,
+    RAPTOR,
+    CONTRACTION_HIERARCHIES
+};
+ 
 struct RoutingSettings {
     double bus_wait_time = 0;
     double bus_velocity = 0;
+    RouterEngine router_engine = RouterEngine::ALL_PAIRS;
+    size_t router_build_threads = 0;
+};
+ 
+struct RouteCacheSettings {
+    size_t capacity = 4096;
+    std::string warmup_file;
+    // hit and miss counts of the batch are written to stderr, to size the cache
+    bool report_stats = false;
+};
+ 
+// parts of a saved base that only some requests read, a flat base loads them on first use
+enum class BaseSection {
+    DISTANCES,
+    NAME_ORDER,
+    STOP_GRID,
+    RENDER_SETTINGS,
+    RENDERED_MAP,
+    ROUTER
 };
  
 struct RouterByStop {
@@ -0,0 +1,488 @@
+#include "flat_serialization.h"
+ 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+ 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+ 
+namespace serialization {
+ 
+namespace {
+ 
+template <typename T>
+using Table = transport_catalogue::Table<T>;
+ 
+template <typename T>
+void AppendBytes(std::string& bytes, const T* data, size_t count) {
+    bytes.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+ 
+template <typename T>
+void AppendTable(std::string& bytes, const Table<T>& table) {
+    AppendBytes(bytes, table.data(), table.size());
+}
+ 
+// a section viewed in place, element alignment is guaranteed by the section alignment
+template <typename T>
+Table<T> GetTable(const MappedFile& file, const flat::Header& header, flat::SectionId id) {
+    const flat::Section& section = header.sections[id];
+    
+    if (section.offset % flat::ALIGNMENT != 0
+        || section.offset > file.size()
+        || section.size > file.size() - section.offset
+        || section.size % sizeof(T) != 0) {
+        throw std::runtime_error("corrupted sections in serialized file");
+    }
+    
+    return Table<T>::View(reinterpret_cast<const T*>(file.data() + section.offset), section.size / sizeof(T));
+}
+ 
+transport_catalogue::NameTable GetNameTable(const MappedFile& file, const flat::Header& header, 
+                                            flat::SectionId chars_id, flat::SectionId offsets_id) {
+    
+    auto chars = GetTable<char>(file, header, chars_id);
+    auto offsets = GetTable<uint64_t>(file, header, offsets_id);
+    
+    if (offsets.empty() || offsets[0] != 0 || offsets.back() != chars.size()
+        || !std::is_sorted(offsets.begin(), offsets.end())) {
+        throw std::runtime_error("corrupted names in serialized file");
+    }
+    
+    return {std::move(chars), std::move(offsets)};
+}
+ 
+// an index holds one slot per distinct name, every slot an id of a name
+transport_catalogue::NameIndex GetNameIndex(const MappedFile& file, const flat::Header& header, 
+                                            flat::SectionId seeds_id, flat::SectionId slots_id, size_t names_count) {
+    
+    auto seeds = GetTable<uint32_t>(file, header, seeds_id);
+    auto slots = GetTable<uint32_t>(file, header, slots_id);
+    
+    if (seeds.empty() != slots.empty() || slots.size() > names_count
+        || std::any_of(slots.begin(), slots.end(), [names_count](uint32_t id) {return id >= names_count;})) {
+        throw std::runtime_error("corrupted name index in serialized file");
+    }
+    
+    return {std::move(seeds), std::move(slots)};
+}
+ 
+transport_catalogue::TransportCatalogue DeserializationFlatTransportCatalogue(const MappedFile& file, const flat::Header& header) {
+ 
+    transport_catalogue::TransportCatalogue transport_catalogue;
+    
+    auto stop_names = GetNameTable(file, header, flat::STOP_NAME_CHARS, flat::STOP_NAME_OFFSETS);
+    auto stop_coordinates = GetTable<geo::Coordinates>(file, header, flat::STOP_COORDINATES);
+    auto stop_points = GetTable<geo::SpherePoint>(file, header, flat::STOP_POINTS);
+    auto stop_name_index = GetNameIndex(file, header, flat::STOP_NAME_INDEX_SEEDS, flat::STOP_NAME_INDEX_SLOTS, stop_names.size());
+    
+    const size_t stops_count = stop_names.size();
+    
+    if (stop_coordinates.size() != stops_count || stop_points.size() != stops_count) {
+        throw std::runtime_error("corrupted stops in serialized file");
+    }
+    
+    auto bus_names = GetNameTable(file, header, flat::BUS_NAME_CHARS, flat::BUS_NAME_OFFSETS);
+    auto bus_stop_offsets = GetTable<uint32_t>(file, header, flat::BUS_STOP_OFFSETS);
+    auto bus_stops = GetTable<domain::StopId>(file, header, flat::BUS_STOPS);
+    auto bus_distances = GetTable<size_t>(file, header, flat::BUS_DISTANCES);
+    auto bus_is_roundtrip = GetTable<uint8_t>(file, header, flat::BUS_IS_ROUNDTRIP);
+    auto bus_stats = GetTable<domain::BusStats>(file, header, flat::BUS_STATS);
+    auto bus_name_index = GetNameIndex(file, header, flat::BUS_NAME_INDEX_SEEDS, flat::BUS_NAME_INDEX_SLOTS, bus_names.size());
+    
+    const size_t buses_count = bus_names.size();
+    
+    if (bus_stop_offsets.size() != buses_count + 1
+        || bus_stop_offsets[0] != 0
+        || bus_stop_offsets.back() != bus_stops.size()
+        || !std::is_sorted(bus_stop_offsets.begin(), bus_stop_offsets.end())
+        || bus_distances.size() != bus_stops.size()
+        || bus_is_roundtrip.size() != buses_count
+        || bus_stats.size() != buses_count
+        || std::any_of(bus_stops.begin(), bus_stops.end(), [stops_count](domain::StopId stop) {return stop >= stops_count;})) {
+        throw std::runtime_error("corrupted buses in serialized file");
+    }
+    
+    transport_catalogue.SetStops(std::move(stop_names), std::move(stop_coordinates), std::move(stop_points));
+    transport_catalogue.SetBuses(std::move(bus_names),
+                                 std::move(bus_stop_offsets),
+                                 std::move(bus_stops),
+                                 std::move(bus_distances),
+                                 std::move(bus_is_roundtrip),
+                                 std::move(bus_stats));
+    transport_catalogue.SetNameIndex(std::move(stop_name_index), std::move(bus_name_index));
+    
+    auto stop_bus_offsets = GetTable<uint32_t>(file, header, flat::STOP_BUS_OFFSETS);
+    auto stop_bus_ids = GetTable<domain::BusId>(file, header, flat::STOP_BUS_IDS);
+    
+    CheckStopBuses(transport_catalogue, stop_bus_offsets, stop_bus_ids);
+    transport_catalogue.SetStopBuses(std::move(stop_bus_offsets), std::move(stop_bus_ids));
+    
+    return transport_catalogue;
+}
+ 
+void LoadDistances(transport_catalogue::TransportCatalogue& transport_catalogue, const MappedFile& file, const flat::Header& header) {
+    
+    const auto stops_count = transport_catalogue.GetStopsCount();
+    
+    const auto distance_counts = GetTable<flat::DistanceCounts>(file, header, flat::DISTANCE_COUNTS);
+    auto distance_slots = GetTable<transport_catalogue::DistanceTable::Slot>(file, header, flat::DISTANCE_SLOTS);
+    
+    // lookups probe until an empty slot, so a table is a power of two at most half full
+    if (distance_counts.size() != 1
+        || distance_slots.empty() 
+        || (distance_slots.size() & (distance_slots.size() - 1)) != 0) {
+        throw std::runtime_error("corrupted distances in serialized file");
+    }
+    
+    size_t used_slots = 0;
+    size_t size = 0;
+    
+    for (const auto& slot : distance_slots) {
+    
+        if (slot.key == transport_catalogue::DistanceTable::EMPTY_KEY) {
+            continue;
+        }
+        
+        const uint64_t low = slot.key >> 32;
+        const uint64_t high = slot.key & 0xffffffffULL;
+        
+        if (low > high || high >= stops_count) {
+            throw std::runtime_error("corrupted distances in serialized file");
+        }
+        
+        ++used_slots;
+        size += (slot.forward != transport_catalogue::DistanceTable::NO_DISTANCE) 
+              + (slot.backward != transport_catalogue::DistanceTable::NO_DISTANCE);
+    }
+    
+    if (2 * used_slots > distance_slots.size()
+        || used_slots != distance_counts[0].used_slots
+        || size != distance_counts[0].size) {
+        throw std::runtime_error("corrupted distances in serialized file");
+    }
+    
+    transport_catalogue.SetDistances({std::move(distance_slots), used_slots, size});
+}
+ 
+void LoadNameOrder(transport_catalogue::TransportCatalogue& transport_catalogue, const MappedFile& file, const flat::Header& header) {
+    
+    auto stops_by_name = GetTable<domain::StopId>(file, header, flat::STOPS_BY_NAME);
+    auto buses_by_name = GetTable<domain::BusId>(file, header, flat::BUSES_BY_NAME);
+    
+    CheckNameOrder(transport_catalogue, stops_by_name, buses_by_name);
+    transport_catalogue.SetNameOrder(std::move(stops_by_name), std::move(buses_by_name));
+}
+    
+void LoadStopGrid(transport_catalogue::TransportCatalogue& transport_catalogue, const MappedFile& file, const flat::Header& header) {
+    
+    const auto stops_count = transport_catalogue.GetStopsCount();
+    
+    const auto stop_grid_layout = GetTable<flat::StopGridLayout>(file, header, flat::STOP_GRID_LAYOUT);
+    auto stop_grid_cell_offsets = GetTable<uint32_t>(file, header, flat::STOP_GRID_CELL_OFFSETS);
+    auto stop_grid_stop_ids = GetTable<domain::StopId>(file, header, flat::STOP_GRID_STOP_IDS);
+    auto stop_grid_points = GetTable<geo::SpherePoint>(file, header, flat::STOP_GRID_POINTS);
+    
+    if (stop_grid_layout.size() != 1) {
+        throw std::runtime_error("corrupted stop grid in serialized file");
+    }
+    
+    if (stops_count == 0) {
+        transport_catalogue.BuildStopGrid();
+        return;
+    }
+    
+    transport_catalogue::StopGrid::Layout layout;
+    
+    layout.min = {stop_grid_layout[0].min_latitude, stop_grid_layout[0].min_longitude};
+    layout.cell_height = stop_grid_layout[0].cell_height;
+    layout.cell_width = stop_grid_layout[0].cell_width;
+    layout.rows = stop_grid_layout[0].rows;
+    layout.cols = stop_grid_layout[0].cols;
+    
+    CheckStopGrid(transport_catalogue, layout, stop_grid_cell_offsets, stop_grid_stop_ids);
+    
+    if (stop_grid_points.size() != stops_count) {
+        throw std::runtime_error("corrupted stop grid in serialized file");
+    }
+    
+    transport_catalogue.SetStopGrid(transport_catalogue::StopGrid(layout, 
+                                                                  std::move(stop_grid_cell_offsets), 
+                                                                  std::move(stop_grid_stop_ids), 
+                                                                  std::move(stop_grid_points)));
+}
+ 
+} // namespace
+ 
+#if defined(__unix__) || defined(__APPLE__)
+ 
+MappedFile::MappedFile(const std::string& file_name) {
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    
+    if (fd < 0) {
+        throw std::runtime_error("cannot open serialized file");
+    }
+    
+    struct stat file_stat;
+    
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("cannot open serialized file");
+    }
+    
+    size_ = static_cast<size_t>(file_stat.st_size);
+    
+    if (size_ != 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("cannot map serialized file");
+        }
+        
+        data_ = static_cast<const char*>(data);
+    }
+    
+    // the mapping stays valid once the descriptor is closed
+    close(fd);
+}
+ 
+MappedFile::~MappedFile() {
+ 
+    if (data_ != nullptr && buffer_.empty()) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+ 
+#else
+ 
+MappedFile::MappedFile(const std::string& file_name) {
+    std::ifstream in_file(file_name, std::ios::binary);
+    
+    if (!in_file) {
+        throw std::runtime_error("cannot open serialized file");
+    }
+    
+    buffer_.assign(std::istreambuf_iterator<char>(in_file), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+ 
+MappedFile::~MappedFile() = default;
+ 
+#endif
+ 
+const char* MappedFile::data() const {
+    return data_;
+}
+ 
+size_t MappedFile::size() const {
+    return size_;
+}
+ 
+bool IsFlatCatalogue(const std::string& file_name) {
+    std::ifstream in_file(file_name, std::ios::binary);
+    char magic[sizeof(flat::MAGIC)] = {};
+    
+    in_file.read(magic, sizeof(magic));
+    
+    return in_file && std::memcmp(magic, flat::MAGIC, sizeof(magic)) == 0;
+}
+ 
+void SerializationFlatCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                                const map_renderer::RenderSettings& render_settings,
+                                const std::string& rendered_map,
+                                const transport_catalogue::detail::router::TransportRouter& transport_router,
+                                std::ostream& out) {
+    
+    std::vector<std::string> sections(flat::SECTIONS_COUNT);
+    
+    const auto& stop_names = transport_catalogue.GetStopNames();
+    const auto stop_coordinates = transport_catalogue.GetStopsCoordinates();
+        
+    AppendTable(sections[flat::STOP_NAME_CHARS], stop_names.GetChars());
+    AppendTable(sections[flat::STOP_NAME_OFFSETS], stop_names.GetOffsets());
+    AppendBytes(sections[flat::STOP_COORDINATES], stop_coordinates.begin(), stop_coordinates.size());
+    AppendTable(sections[flat::STOP_POINTS], transport_catalogue.GetStopPoints());
+        
+    const auto& bus_names = transport_catalogue.GetBusNames();
+    uint32_t stops_end = 0;
+    
+    AppendTable(sections[flat::BUS_NAME_CHARS], bus_names.GetChars());
+    AppendTable(sections[flat::BUS_NAME_OFFSETS], bus_names.GetOffsets());
+    AppendBytes(sections[flat::BUS_STOP_OFFSETS], &stops_end, 1);
+    
+    for (domain::BusId bus = 0; bus < transport_catalogue.GetBusesCount(); ++bus) {
+        const auto stops = transport_catalogue.GetBusStops(bus);
+        const auto distances = transport_catalogue.GetBusDistances(bus);
+        const uint8_t is_roundtrip = transport_catalogue.IsRoundtrip(bus);
+        
+        stops_end += static_cast<uint32_t>(stops.size());
+        
+        AppendBytes(sections[flat::BUS_STOP_OFFSETS], &stops_end, 1);
+        AppendBytes(sections[flat::BUS_STOPS], stops.begin(), stops.size());
+        AppendBytes(sections[flat::BUS_DISTANCES], distances.begin(), distances.size());
+        AppendBytes(sections[flat::BUS_IS_ROUNDTRIP], &is_roundtrip, 1);
+        AppendBytes(sections[flat::BUS_STATS], &transport_catalogue.GetBusStats(bus), 1);
+    }
+    
+    // built anew over exactly the saved names, so names added after BuildNameIndex are found too
+    transport_catalogue::NameIndex stop_name_index;
+    transport_catalogue::NameIndex bus_name_index;
+    
+    stop_name_index.Build(stop_names);
+    bus_name_index.Build(bus_names);
+        
+    AppendTable(sections[flat::STOP_NAME_INDEX_SEEDS], stop_name_index.GetSeeds());
+    AppendTable(sections[flat::STOP_NAME_INDEX_SLOTS], stop_name_index.GetSlots());
+    AppendTable(sections[flat::BUS_NAME_INDEX_SEEDS], bus_name_index.GetSeeds());
+    AppendTable(sections[flat::BUS_NAME_INDEX_SLOTS], bus_name_index.GetSlots());
+        
+    const auto& distance_table = transport_catalogue.GetDistanceTable();
+    const flat::DistanceCounts distance_counts = {distance_table.GetUsedSlots(), distance_table.size()};
+        
+    AppendBytes(sections[flat::DISTANCE_COUNTS], &distance_counts, 1);
+    AppendTable(sections[flat::DISTANCE_SLOTS], distance_table.GetSlots());
+        
+    AppendTable(sections[flat::STOP_BUS_OFFSETS], transport_catalogue.GetStopBusOffsets());
+    AppendTable(sections[flat::STOP_BUS_IDS], transport_catalogue.GetStopBusIds());
+        
+    AppendTable(sections[flat::STOPS_BY_NAME], transport_catalogue.GetStopsByName());
+    AppendTable(sections[flat::BUSES_BY_NAME], transport_catalogue.GetBusesByName());
+    
+    const auto& stop_grid = transport_catalogue.GetStopGrid();
+    const auto& layout = stop_grid.GetLayout();
+    const flat::StopGridLayout stop_grid_layout = {layout.min.latitude, layout.min.longitude, layout.cell_height, layout.cell_width, layout.rows, layout.cols};
+    
+    AppendBytes(sections[flat::STOP_GRID_LAYOUT], &stop_grid_layout, 1);
+    AppendTable(sections[flat::STOP_GRID_CELL_OFFSETS], stop_grid.GetCellOffsets());
+    AppendTable(sections[flat::STOP_GRID_STOP_IDS], stop_grid.GetStopIds());
+    AppendTable(sections[flat::STOP_GRID_POINTS], stop_grid.GetStopPoints());
+    
+    SerializationRenderSettings(render_settings).SerializePartialToString(&sections[flat::RENDER_SETTINGS]);
+    sections[flat::RENDERED_MAP] = rendered_map;
+    
+    // routing settings and the router, as the protobuf base keeps them
+    transport_catalogue_protobuf::Catalogue router_proto;
+    
+    *router_proto.mutable_routing_settings() = SerializationRoutingSettings(transport_router.GetRoutingSettings());
+    
+    if (transport_router.GetRoutingSettings().router_engine != domain::RouterEngine::RAPTOR) {
+        *router_proto.mutable_transport_router() = SerializationTransportRouter(transport_catalogue, transport_router);
+    }
+    
+    router_proto.SerializePartialToString(&sections[flat::ROUTER]);
+    
+    flat::Header header = {};
+    
+    std::memcpy(header.magic, flat::MAGIC, sizeof(header.magic));
+    header.byte_order = flat::BYTE_ORDER_MARK;
+    header.sections_count = flat::SECTIONS_COUNT;
+    
+    uint64_t offset = sizeof(header);
+    
+    for (uint32_t id = 0; id < flat::SECTIONS_COUNT; ++id) {
+        offset = (offset + flat::ALIGNMENT - 1) / flat::ALIGNMENT * flat::ALIGNMENT;
+        header.sections[id] = {offset, sections[id].size()};
+        offset += sections[id].size();
+    }
+    
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset = sizeof(header);
+    
+    for (uint32_t id = 0; id < flat::SECTIONS_COUNT; ++id) {
+        const std::string padding(header.sections[id].offset - offset, '\0');
+        
+        out.write(padding.data(), padding.size());
+        out.write(sections[id].data(), sections[id].size());
+        offset = header.sections[id].offset + sections[id].size();
+    }
+}
+ 
+Catalogue DeserializationFlatCatalogue(const std::string& file_name) {
+ 
+    auto file = std::make_shared<const MappedFile>(file_name);
+    
+    if (file->size() < sizeof(flat::Header)) {
+        throw std::runtime_error("corrupted header in serialized file");
+    }
+    
+    flat::Header header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    
+    if (std::memcmp(header.magic, flat::MAGIC, sizeof(header.magic)) != 0
+        || header.byte_order != flat::BYTE_ORDER_MARK
+        || header.sections_count != flat::SECTIONS_COUNT) {
+        throw std::runtime_error("corrupted header in serialized file");
+    }
+    
+    // the rest waits in the mapping until a request needs it
+    return {file,
+            DeserializationFlatTransportCatalogue(*file, header),
+            {},
+            {},
+            {},
+            {domain::BaseSection::DISTANCES, 
+             domain::BaseSection::NAME_ORDER, 
+             domain::BaseSection::STOP_GRID, 
+             domain::BaseSection::RENDER_SETTINGS, 
+             domain::BaseSection::RENDERED_MAP, 
+             domain::BaseSection::ROUTER}};
+}
+    
+void LoadFlatSection(Catalogue& catalogue, domain::BaseSection section) {
+    
+    const MappedFile& file = *catalogue.base_file_;
+    auto& transport_catalogue = catalogue.transport_catalogue_;
+    
+    flat::Header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    
+    switch (section) {
+        case domain::BaseSection::DISTANCES:
+            LoadDistances(transport_catalogue, file, header);
+            break;
+        case domain::BaseSection::NAME_ORDER:
+            LoadNameOrder(transport_catalogue, file, header);
+            break;
+        case domain::BaseSection::STOP_GRID:
+            LoadStopGrid(transport_catalogue, file, header);
+            break;
+        case domain::BaseSection::RENDER_SETTINGS: {
+            const auto render_settings = GetTable<char>(file, header, flat::RENDER_SETTINGS);
+            transport_catalogue_protobuf::RenderSettings render_settings_proto;
+            
+            if (!render_settings_proto.ParseFromArray(render_settings.data(), static_cast<int>(render_settings.size()))) {
+                throw std::runtime_error("cannot parse serialized render settings");
+            }
+            
+            catalogue.render_settings_ = DeserializationRenderSettings(render_settings_proto);
+            break;
+        }
+        case domain::BaseSection::RENDERED_MAP: {
+            const auto rendered_map = GetTable<char>(file, header, flat::RENDERED_MAP);
+            catalogue.rendered_map_.assign(rendered_map.data(), rendered_map.size());
+            break;
+        }
+        case domain::BaseSection::ROUTER: {
+            const auto router = GetTable<char>(file, header, flat::ROUTER);
+            transport_catalogue_protobuf::Catalogue router_proto;
+            
+            if (!router_proto.ParseFromArray(router.data(), static_cast<int>(router.size()))) {
+                throw std::runtime_error("cannot parse serialized router");
+            }
+            
+            DeserializationCatalogueRouter(router_proto, catalogue);
+            break;
+        }
+    }
+}
+ 
+} // namespace serialization
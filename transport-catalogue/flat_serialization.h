@@ -0,0 +1,126 @@
+#pragma once
+ 
+#include <cstdint>
+#include <string>
+#include <vector>
+ 
+#include "serialization.h"
+ 
+// flat base: a header with a table of sections, each a plain-data catalogue table as the catalogue keeps it,
+// name indexes and sphere points included; every section starts at a multiple of 8 bytes, so loading
+// points the catalogue's tables at the mapped file. The loader still checks every saved id and index
+// the way the protobuf loader does, a corrupted base is rejected instead of read out of bounds.
+// render settings and the router stay protobuf messages, each in its own section
+namespace serialization {
+ 
+// read-only view of a whole file, mapped where the system allows, read into memory otherwise
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& file_name);
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const char* data() const;
+    size_t size() const;
+ 
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<char> buffer_;
+};
+ 
+namespace flat {
+ 
+constexpr char MAGIC[8] = {'T', 'C', 'F', 'L', 'A', 'T', '\0', '1'};
+// written as is, a base read on a machine of the other byte order fails this check
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t ALIGNMENT = 8;
+ 
+enum SectionId : uint32_t {
+    STOP_NAME_CHARS,
+    STOP_NAME_OFFSETS,
+    STOP_COORDINATES,
+    STOP_POINTS,
+    STOP_NAME_INDEX_SEEDS,
+    STOP_NAME_INDEX_SLOTS,
+    BUS_NAME_CHARS,
+    BUS_NAME_OFFSETS,
+    BUS_STOP_OFFSETS,
+    BUS_STOPS,
+    BUS_DISTANCES,
+    BUS_IS_ROUNDTRIP,
+    BUS_STATS,
+    BUS_NAME_INDEX_SEEDS,
+    BUS_NAME_INDEX_SLOTS,
+    STOP_BUS_OFFSETS,
+    STOP_BUS_IDS,
+    DISTANCE_COUNTS,
+    DISTANCE_SLOTS,
+    STOPS_BY_NAME,
+    BUSES_BY_NAME,
+    STOP_GRID_LAYOUT,
+    STOP_GRID_CELL_OFFSETS,
+    STOP_GRID_STOP_IDS,
+    STOP_GRID_POINTS,
+    RENDER_SETTINGS,
+    RENDERED_MAP,
+    ROUTER,
+    SECTIONS_COUNT
+};
+ 
+struct Section {
+    uint64_t offset;
+    uint64_t size;
+};
+ 
+struct Header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t sections_count;
+    Section sections[SECTIONS_COUNT];
+};
+ 
+// the counts a distance table keeps next to its slots
+struct DistanceCounts {
+    uint64_t used_slots;
+    uint64_t size;
+};
+ 
+struct StopGridLayout {
+    double min_latitude;
+    double min_longitude;
+    double cell_height;
+    double cell_width;
+    uint32_t rows;
+    uint32_t cols;
+};
+ 
+static_assert(sizeof(Header) == 16 + 16 * SECTIONS_COUNT);
+static_assert(sizeof(DistanceCounts) == 16);
+static_assert(sizeof(StopGridLayout) == 40);
+ 
+// the catalogue's own element types, saved as they are
+static_assert(sizeof(size_t) == 8);
+static_assert(sizeof(geo::Coordinates) == 16);
+static_assert(sizeof(geo::SpherePoint) == 24);
+static_assert(sizeof(domain::BusStats) == 32);
+static_assert(sizeof(transport_catalogue::DistanceTable::Slot) == 16);
+ 
+} // namespace flat
+ 
+bool IsFlatCatalogue(const std::string& file_name);
+ 
+void SerializationFlatCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                                const map_renderer::RenderSettings& render_settings,
+                                const std::string& rendered_map,
+                                const transport_catalogue::detail::router::TransportRouter& transport_router,
+                                std::ostream& out);
+ 
+// maps the file and views the stop and bus tables in it, the other sections are left pending;
+// the loaded Catalogue keeps the mapping alive
+Catalogue DeserializationFlatCatalogue(const std::string& file_name);
+void LoadFlatSection(Catalogue& catalogue, domain::BaseSection section);
+ 
+} // namespace serialization
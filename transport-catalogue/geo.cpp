@@ -1,5 +1,11 @@
 #include "geo.h"
 
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace geo {
     bool Coordinates::operator==(const Coordinates& other) const {
         return latitude == other.latitude && longitude == other.longitude;
@@ -7,4 +13,116 @@ namespace geo {
     bool Coordinates::operator!=(const Coordinates& other) const {
         return !(*this == other);
     }
+
+    namespace {
+        // a chord of length c spans the angle 2 * asin(c / 2)
+        double ChordToDistance(double chord) {
+            return 2. * std::asin(std::min(chord / 2., 1.)) * EARTH_RADIUS;
+        }
+
+#ifdef __SSE2__
+        // past this half chord (about 77 degrees of arc) the rational asin below loses accuracy
+        const double ASIN_POLY_LIMIT = 0.625;
+
+        // Cephes' rational approximation of asin on [0, 0.625], about one ulp from std::asin
+        __m128d AsinSmall(__m128d x) {
+            const __m128d z = _mm_mul_pd(x, x);
+
+            __m128d p = _mm_set1_pd(4.253011369004428248960E-3);
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-6.019598008014123785661E-1));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(5.444622390564711410273E0));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-1.626247967210700244449E1));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(1.956261983317594739197E1));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-8.198089802484824371615E0));
+
+            __m128d q = _mm_add_pd(z, _mm_set1_pd(-1.474091372988853791896E1));
+            q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(7.049610280856842141659E1));
+            q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(-1.471791292232726029859E2));
+            q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(1.395105614657485689735E2));
+            q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(-4.918853881490881290097E1));
+
+            return _mm_add_pd(x, _mm_mul_pd(_mm_mul_pd(x, z), _mm_div_pd(p, q)));
+        }
+
+        // distances of two point pairs given the coordinate differences of each pair
+        __m128d ComputeDistances2(__m128d dx, __m128d dy, __m128d dz) {
+            const __m128d chord = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz)));
+            const __m128d half_chord = _mm_mul_pd(chord, _mm_set1_pd(0.5));
+
+            if (_mm_movemask_pd(_mm_cmpgt_pd(half_chord, _mm_set1_pd(ASIN_POLY_LIMIT))) != 0) {
+                double chords[2];
+                _mm_storeu_pd(chords, chord);
+                return _mm_set_pd(ChordToDistance(chords[1]), ChordToDistance(chords[0]));
+            }
+
+            return _mm_mul_pd(AsinSmall(half_chord), _mm_set1_pd(2. * EARTH_RADIUS));
+        }
+#endif
+    } // namespace
+
+    SpherePoint ToSpherePoint(Coordinates coordinates) {
+        static const double dr = M_PI / 180.;
+        const double cos_latitude = std::cos(coordinates.latitude * dr);
+
+        return {cos_latitude * std::cos(coordinates.longitude * dr),
+                cos_latitude * std::sin(coordinates.longitude * dr),
+                std::sin(coordinates.latitude * dr)};
+    }
+
+    double ComputeDistance(const SpherePoint& from, const SpherePoint& to) {
+        const double dx = from.x - to.x;
+        const double dy = from.y - to.y;
+        const double dz = from.z - to.z;
+
+        return ChordToDistance(std::sqrt(dx * dx + dy * dy + dz * dz));
+    }
+
+    void ComputeDistances(const SpherePoint& from, const SpherePoint* points, size_t count, double* distances) {
+        size_t i = 0;
+
+#ifdef __SSE2__
+        const __m128d from_x = _mm_set1_pd(from.x);
+        const __m128d from_y = _mm_set1_pd(from.y);
+        const __m128d from_z = _mm_set1_pd(from.z);
+
+        for (; i + 2 <= count; i += 2) {
+            const __m128d dx = _mm_sub_pd(from_x, _mm_set_pd(points[i + 1].x, points[i].x));
+            const __m128d dy = _mm_sub_pd(from_y, _mm_set_pd(points[i + 1].y, points[i].y));
+            const __m128d dz = _mm_sub_pd(from_z, _mm_set_pd(points[i + 1].z, points[i].z));
+
+            _mm_storeu_pd(distances + i, ComputeDistances2(dx, dy, dz));
+        }
+#endif
+
+        for (; i < count; ++i) {
+            distances[i] = ComputeDistance(from, points[i]);
+        }
+    }
+
+    double ComputePathLength(const SpherePoint* points, size_t count) {
+        double length = 0.;
+        size_t i = 1;
+
+#ifdef __SSE2__
+        __m128d lengths = _mm_setzero_pd();
+
+        for (; i + 2 <= count; i += 2) {
+            const __m128d dx = _mm_sub_pd(_mm_set_pd(points[i].x, points[i - 1].x), _mm_set_pd(points[i + 1].x, points[i].x));
+            const __m128d dy = _mm_sub_pd(_mm_set_pd(points[i].y, points[i - 1].y), _mm_set_pd(points[i + 1].y, points[i].y));
+            const __m128d dz = _mm_sub_pd(_mm_set_pd(points[i].z, points[i - 1].z), _mm_set_pd(points[i + 1].z, points[i].z));
+
+            lengths = _mm_add_pd(lengths, ComputeDistances2(dx, dy, dz));
+        }
+
+        double lanes[2];
+        _mm_storeu_pd(lanes, lengths);
+        length = lanes[0] + lanes[1];
+#endif
+
+        for (; i < count; ++i) {
+            length += ComputeDistance(points[i - 1], points[i]);
+        }
+
+        return length;
+    }
 } // namespace geo
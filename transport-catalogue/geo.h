@@ -3,6 +3,7 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <cmath>
+#include <cstddef>
 
 namespace geo {
     struct Coordinates {
@@ -25,4 +26,24 @@ namespace geo {
             + cos(from.latitude * dr) * cos(to.latitude * dr) * cos(abs(from.longitude - to.longitude) * dr))
             * EARTH_RADIUS;
     }
+
+    // a point of the unit sphere; computed once per stop, it turns a distance into arithmetic and one asin
+    struct SpherePoint {
+        double x;
+        double y;
+        double z;
+    };
+
+    SpherePoint ToSpherePoint(Coordinates coordinates);
+
+    // great circle distance from the chord between the points; it stays within 1e-8 relative of
+    // ComputeDistance above a kilometre and within 0.15 m below, where acos of a dot product
+    // itself rounds that coarsely (and may give NaN for nearly coincident points)
+    double ComputeDistance(const SpherePoint& from, const SpherePoint& to);
+
+    // distances[i] = ComputeDistance(from, points[i]), two points per step where SSE2 is available
+    void ComputeDistances(const SpherePoint& from, const SpherePoint* points, size_t count, double* distances);
+
+    // sum of the distances between consecutive points, vectorized the same way
+    double ComputePathLength(const SpherePoint* points, size_t count);
 } // namespace geo
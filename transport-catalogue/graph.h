@@ -2,7 +2,11 @@
  
 #include "ranges.h"
  
+#include <cstdint>
 #include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
 #include <vector>
  
 namespace graph {
@@ -19,23 +23,62 @@ struct Edge {
  
 template <typename Weight>
 class DirectedWeightedGraph {
-private:
+public:
     using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    
+    // walks an incidence list, or the run of consecutive edge ids of a frozen graph
+    class IncidentEdgeIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = EdgeId;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const EdgeId*;
+        using reference = EdgeId;
+        
+        IncidentEdgeIterator(const EdgeId* edge_ids, EdgeId position) : edge_ids_(edge_ids)
+                                                                      , position_(position) {}
+        
+        EdgeId operator*() const {return edge_ids_ ? edge_ids_[position_] : position_;}
+        
+        IncidentEdgeIterator& operator++() {
+            ++position_;
+            return *this;
+        }
+        
+        bool operator==(const IncidentEdgeIterator& other) const {return position_ == other.position_;}
+        bool operator!=(const IncidentEdgeIterator& other) const {return position_ != other.position_;}
+        
+    private:
+        const EdgeId* edge_ids_;
+        EdgeId position_;
+    };
+    
+    using IncidentEdgesRange = ranges::Range<IncidentEdgeIterator>;
  
-public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
+    
     EdgeId AddEdge(const Edge<Weight>& edge);
     
+    // packs the finished graph into CSR arrays and renumbers the edges in incidence order;
+    // returns the new id of every old edge id, no edge can be added afterwards
+    std::vector<EdgeId> Freeze();
+    bool IsFrozen() const;
+    
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
  
 private:
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+    
+    // frozen graph: edges of vertex v are the ids [offsets_[v], offsets_[v + 1])
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> sources_;
+    std::vector<uint32_t> targets_;
+    std::vector<Weight> weights_;
 };
  
 template <typename Weight>
@@ -43,6 +86,10 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count) : inci
  
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (IsFrozen()) {
+        throw std::logic_error("cannot add an edge to a frozen graph");
+    }
+    
     edges_.push_back(edge);
     
     const EdgeId id = edges_.size() - 1;
@@ -53,17 +100,66 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
 }
  
 template <typename Weight>
-size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {return incidence_lists_.size();}
+std::vector<EdgeId> DirectedWeightedGraph<Weight>::Freeze() {
+    if (IsFrozen()) {
+        throw std::logic_error("graph is already frozen");
+    }
+    
+    std::vector<EdgeId> new_edge_ids(edges_.size());
+    
+    offsets_.reserve(incidence_lists_.size() + 1);
+    sources_.reserve(edges_.size());
+    targets_.reserve(edges_.size());
+    weights_.reserve(edges_.size());
+    
+    offsets_.push_back(0);
+    
+    for (VertexId vertex = 0; vertex < incidence_lists_.size(); ++vertex) {
+        
+        for (const EdgeId edge_id : incidence_lists_[vertex]) {
+            new_edge_ids[edge_id] = targets_.size();
+            
+            sources_.push_back(vertex);
+            targets_.push_back(edges_[edge_id].to);
+            weights_.push_back(edges_[edge_id].weight);
+        }
+        
+        offsets_.push_back(targets_.size());
+    }
+    
+    edges_ = {};
+    incidence_lists_ = {};
+    
+    return new_edge_ids;
+}
+ 
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {return !offsets_.empty();}
+ 
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
+    return IsFrozen() ? offsets_.size() - 1 : incidence_lists_.size();
+}
  
 template <typename Weight>
-size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {return edges_.size();}
+size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
+    return IsFrozen() ? targets_.size() : edges_.size();
+}
  
 template <typename Weight>
-const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {return edges_.at(edge_id);}
+Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    return IsFrozen() ? Edge<Weight>{sources_[edge_id], targets_[edge_id], weights_[edge_id]} : edges_[edge_id];
+}
  
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    if (IsFrozen()) {
+        return {IncidentEdgeIterator(nullptr, offsets_[vertex]), IncidentEdgeIterator(nullptr, offsets_[vertex + 1])};
+    }
+    
+    const IncidenceList& incidence_list = incidence_lists_[vertex];
+    
+    return {IncidentEdgeIterator(incidence_list.data(), 0), IncidentEdgeIterator(incidence_list.data(), incidence_list.size())};
 }
  
 } // namespace graph
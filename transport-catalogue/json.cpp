@@ -489,7 +489,7 @@ void PrintNode(const Node& node, const PrintContext& context) {
         }, node.GetValue());
 }
     
-void print(const Document& document, std::ostream& output) {
+void Print(const Document& document, std::ostream& output) {
     PrintNode(document.GetRoot(), PrintContext{output});
 }
  
@@ -1,4 +1,4 @@
-#include "json_Builder.h"
+#include "json_builder.h"
  
 namespace transport_catalogue {
 namespace detail {
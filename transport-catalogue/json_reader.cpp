@@ -12,6 +12,10 @@ JSONReader::JSONReader(std::istream& input)
     : document_(json::Load(input)) {
     }    
     
+const Document& JSONReader::GetDocument() const {
+    return document_;
+}
+    
 Stop JSONReader::ParseNodeStop(Node& node) {
     Stop stop;
     Dict stop_node;
@@ -44,8 +48,8 @@ std::vector<Distance> JSONReader::ParseNodeDistances(Node& node, TransportCatalo
             for (auto [Key, Value] : stop_road_map) {
                 last_name = Key;
                 distance = Value.AsInt();
-                distances.push_back({catalogue.GetStop(begin_name), 
-                                     catalogue.GetStop(last_name), distance});
+                distances.push_back({catalogue.GetStop(begin_name).value(), 
+                                     catalogue.GetStop(last_name).value(), distance});
             } 
             
         } catch(...) {
@@ -70,7 +74,7 @@ Bus JSONReader::ParseNodeBus(Node& node, TransportCatalogue& catalogue) {
             bus_stops = bus_node.at("stops").AsArray();
             
             for (Node stop : bus_stops) {
-                bus.stops.push_back(catalogue.GetStop(stop.AsString()));
+                bus.stops.push_back(catalogue.GetStop(stop.AsString()).value());
             }
  
             if (!bus.is_roundtrip) {
@@ -137,6 +141,11 @@ void JSONReader::ParseNodeBase(const Node& root, TransportCatalogue& catalogue){
             catalogue.AddBus(ParseNodeBus(bus, catalogue));
         }
         
+        catalogue.BuildNameOrder();
+        catalogue.BuildStopBuses();
+        catalogue.BuildStopGrid();
+        catalogue.BuildNameIndex();
+        
     } else {
         std::cout << "base_requests is not an array";
     }  
@@ -164,10 +173,27 @@ void JSONReader::ParseNodeStat(const Node& node, std::vector<StatRequest>& stat_
                     
                 } else {
                     req.name = "";
-                    if (req.type == "Route") {
+                    if ((req.type == "Route") || (req.type == "DirectConnection")) {
                         req.from = req_map.at("from").AsString();
                         req.to = req_map.at("to").AsString();
                         
+                    } else if ((req.type == "NearestStops") || (req.type == "StopsInRadius")) {
+                        req.from ="";
+                        req.to = "";
+                        req.point = {req_map.at("latitude").AsDouble(), req_map.at("longitude").AsDouble()};
+                        
+                        if (req.type == "NearestStops") {
+                            req.count = req_map.at("count").AsInt();
+                        } else {
+                            req.radius = req_map.at("radius").AsDouble();
+                        }
+                        
+                    } else if (req.type == "Suggest") {
+                        req.prefix = req_map.at("prefix").AsString();
+                        req.limit = req_map.at("limit").AsInt();
+                        req.from ="";
+                        req.to = "";
+                        
                     } else {
                         req.from ="";
                         req.to = "";
@@ -291,6 +317,26 @@ void JSONReader::ParseNodeRouting(const Node& node, router::RoutingSettings& rou
             route_set.bus_wait_time = route.at("bus_wait_time").AsDouble();
             route_set.bus_velocity = route.at("bus_velocity").AsDouble();
             
+            if (route.count("router_engine")) {
+                const std::string& router_engine = route.at("router_engine").AsString();
+                
+                if (router_engine == "all_pairs") {
+                    route_set.router_engine = RouterEngine::ALL_PAIRS;
+                } else if (router_engine == "dijkstra") {
+                    route_set.router_engine = RouterEngine::DIJKSTRA;
+                } else if (router_engine == "raptor") {
+                    route_set.router_engine = RouterEngine::RAPTOR;
+                } else if (router_engine == "contraction_hierarchies") {
+                    route_set.router_engine = RouterEngine::CONTRACTION_HIERARCHIES;
+                } else {
+                    std::cout << "unknown router engine";
+                }
+            }
+            
+            if (route.count("router_build_threads")) {
+                route_set.router_build_threads = route.at("router_build_threads").AsInt();
+            }
+            
         } catch(...) {
             std::cout << "unable to parse routing settings";
         }
@@ -311,6 +357,22 @@ void JSONReader::ParseNodeSerialization(const Node& node, serialization::Seriali
         try {
             serialization_set.file_name = serialization.at("file").AsString();
  
+            if (serialization.count("format")) {
+                const std::string& format = serialization.at("format").AsString();
+                
+                if (format == "protobuf") {
+                    serialization_set.format = serialization::BaseFormat::PROTOBUF;
+                } else if (format == "flat") {
+                    serialization_set.format = serialization::BaseFormat::FLAT;
+                } else {
+                    std::cout << "unknown serialization format";
+                }
+            }
+ 
+            if (serialization.count("compact")) {
+                serialization_set.compact = serialization.at("compact").AsBool();
+            }
+ 
         } catch(...) {
             std::cout << "unable to parse serialization settings";
         }
@@ -320,6 +382,35 @@ void JSONReader::ParseNodeSerialization(const Node& node, serialization::Seriali
     }
 }
     
+void JSONReader::ParseNodeRouteCache(const Node& node, router::RouteCacheSettings& route_cache_set) {
+    Dict route_cache;
+    
+    if (node.IsDict()) {
+        route_cache = node.AsDict();
+        
+        try {
+            
+            if (route_cache.count("capacity")) {
+                route_cache_set.capacity = route_cache.at("capacity").AsInt();
+            }
+            
+            if (route_cache.count("warmup_file")) {
+                route_cache_set.warmup_file = route_cache.at("warmup_file").AsString();
+            }
+            
+            if (route_cache.count("report_stats")) {
+                route_cache_set.report_stats = route_cache.at("report_stats").AsBool();
+            }
+            
+        } catch(...) {
+            std::cout << "unable to parse route cache settings";
+        }
+        
+    } else {
+        std::cout << "route cache settings is not map";
+    }
+}
+    
 void JSONReader::ParseNodeMakeBase(TransportCatalogue& catalogue, 
                                       map_renderer::RenderSettings& render_settings, 
                                       router::RoutingSettings& routing_settings,
@@ -355,7 +446,8 @@ void JSONReader::ParseNodeMakeBase(TransportCatalogue& catalogue,
 }
     
 void JSONReader::ParseNodeProcessRequests(std::vector<StatRequest>& stat_request,
-                                             serialization::SerializationSettings& serialization_settings) { 
+                                             serialization::SerializationSettings& serialization_settings,
+                                             router::RouteCacheSettings& route_cache_settings) { 
     Dict root_dictionary;
  
     if (document_.GetRoot().IsDict()) {
@@ -370,6 +462,10 @@ void JSONReader::ParseNodeProcessRequests(std::vector<StatRequest>& stat_request
             ParseNodeSerialization(root_dictionary.at("serialization_settings"), serialization_settings);
             
         } catch(...) {}
+        
+        if (root_dictionary.count("route_cache_settings")) {
+            ParseNodeRouteCache(root_dictionary.at("route_cache_settings"), route_cache_settings);
+        }
  
     } else {
         std::cout << "root is not map";
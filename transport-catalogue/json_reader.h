@@ -21,6 +21,7 @@ public:
     void ParseNodeRender(const Node& node, map_renderer::RenderSettings& render_settings);
     void ParseNodeRouting(const Node& node, router::RoutingSettings& route_set);
     void ParseNodeSerialization(const Node& node, serialization::SerializationSettings& serialization_set);
+    void ParseNodeRouteCache(const Node& node, router::RouteCacheSettings& route_cache_set);
     
     void ParseNodeMakeBase(TransportCatalogue& catalogue, 
                               map_renderer::RenderSettings& render_settings, 
@@ -28,7 +29,8 @@ public:
                               serialization::SerializationSettings& serialization_settings);
     
     void ParseNodeProcessRequests(std::vector<StatRequest>& stat_request,
-                                     serialization::SerializationSettings& serialization_settings);
+                                     serialization::SerializationSettings& serialization_settings,
+                                     router::RouteCacheSettings& route_cache_settings);
     
     Stop ParseNodeStop(Node& node);
     Bus ParseNodeBus(Node& node, TransportCatalogue& catalogue);
@@ -1,6 +1,7 @@
 #include <fstream>
 #include <iostream>
  
+#include "flat_serialization.h"
 #include "json_reader.h"
 #include "request_handler.h"
  
@@ -33,6 +34,7 @@ int main(int argc, char* argv[]) {
     RoutingSettings routing_settings;
     
     SerializationSettings serialization_settings;
+    RouteCacheSettings route_cache_settings;
     
     JSONReader json_reader;
     vector<StatRequest> stat_request;   
@@ -41,33 +43,83 @@ int main(int argc, char* argv[]) {
         
         json_reader = JSONReader(cin); 
         
-        json_reader.parse_node_make_base(transport_catalogue, 
-                                         render_settings, 
-                                         routing_settings, 
-                                         serialization_settings);
+        json_reader.ParseNodeMakeBase(transport_catalogue, 
+                                      render_settings, 
+                                      routing_settings, 
+                                      serialization_settings);
+        
+        TransportRouter transport_router;
+        
+        transport_router.SetRoutingSettings(routing_settings);
+        transport_router.BuildRouter(transport_catalogue);
+        
+        // the map depends on nothing a request can change, so it is rendered once here
+        const string rendered_map = RequestHandler().RenderMap(transport_catalogue, render_settings);
         
         ofstream out_file(serialization_settings.file_name, ios::binary);    
-        catalogue_serialization(transport_catalogue, render_settings, routing_settings, out_file);
+        
+        if (serialization_settings.format == BaseFormat::FLAT) {
+            SerializationFlatCatalogue(transport_catalogue, render_settings, rendered_map, transport_router, out_file);
+        } else {
+            SerializationCatalogue(transport_catalogue, 
+                                   render_settings, 
+                                   rendered_map, 
+                                   transport_router, 
+                                   serialization_settings.compact, 
+                                   out_file);
+        }
         
     } else if (mode == "process_requests"sv) {
         
         json_reader = JSONReader(cin);    
         
-        json_reader.parse_node_process_requests(stat_request, 
-                                                serialization_settings);
-        
-        ifstream in_file(serialization_settings.file_name, ios::binary); 
+        json_reader.ParseNodeProcessRequests(stat_request, 
+                                             serialization_settings, 
+                                             route_cache_settings);
         
-        Catalogue catalogue = catalogue_deserialization(in_file);
+        Catalogue catalogue = DeserializationCatalogue(serialization_settings.file_name);
             
         RequestHandler request_handler;       
         
-        request_handler.execute_queries(catalogue.transport_catalogue_, 
-                                        stat_request, 
-                                        catalogue.render_settings_,
-                                        catalogue.routing_settings_);
+        request_handler.SetSectionLoader([&catalogue](BaseSection section) {
+            LoadCatalogueSection(catalogue, section);
+        });
+        
+        catalogue.transport_router_.GetRouteCache().SetCapacity(route_cache_settings.capacity);
         
-        print(request_handler.get_document(), cout); 
+        if (!route_cache_settings.warmup_file.empty()) {
+            ifstream warmup_file(route_cache_settings.warmup_file);
+            
+            try {
+                JSONReader warmup_reader(warmup_file);
+                vector<StatRequest> warmup_requests;
+                
+                warmup_reader.ParseNodeStat(warmup_reader.GetDocument().GetRoot(), warmup_requests);
+                request_handler.WarmRouteCache(catalogue.transport_catalogue_, 
+                                               warmup_requests, 
+                                               catalogue.transport_router_);
+                
+            } catch(...) {
+                cerr << "unable to warm up route cache from "sv << route_cache_settings.warmup_file << endl;
+            }
+        }
+        
+        request_handler.ExecuteQueries(catalogue.transport_catalogue_, 
+                                       stat_request, 
+                                       catalogue.render_settings_,
+                                       catalogue.rendered_map_,
+                                       catalogue.transport_router_);
+        
+        Print(request_handler.GetDocument(), cout); 
+        
+        if (route_cache_settings.report_stats) {
+            const RouteCacheStats stats = catalogue.transport_router_.GetRouteCache().GetStats();
+            
+            cerr << "route cache: hits "sv << stats.hits 
+                 << ", misses "sv << stats.misses 
+                 << ", size "sv << stats.size 
+                 << " of "sv << stats.capacity << endl;
+        }
         
     } else {
         PrintUsage();
@@ -139,17 +139,14 @@ void MapRenderer::SetStopsTextColorProperties(svg::Text& text,
     text.SetFillColor("black");
 }
     
-void MapRenderer::AddLine(std::vector<std::pair<Bus*, int>>& buses_palette) {    
+void MapRenderer::AddLine(const transport_catalogue::TransportCatalogue& catalogue, 
+                          const std::vector<std::pair<BusId, int>>& buses_palette) {    
     std::vector<geo::Coordinates> stops_geo_coords;
     
     for (auto [bus, palette] : buses_palette) { 
         
-        for (Stop* stop : bus->stops) {
-            geo::Coordinates coordinates;
-            coordinates.latitude = stop->latitude;
-            coordinates.longitude = stop->longitude;
-            
-            stops_geo_coords.push_back(coordinates); 
+        for (StopId stop : catalogue.GetBusStops(bus)) {
+            stops_geo_coords.push_back(catalogue.GetStopCoordinates(stop)); 
         }
         
         svg::Polyline bus_line;
@@ -170,18 +167,16 @@ void MapRenderer::AddLine(std::vector<std::pair<Bus*, int>>& buses_palette) {
     }
 }
     
-void MapRenderer::AddBusesName(std::vector<std::pair<Bus*, int>>& buses_palette){    
+void MapRenderer::AddBusesName(const transport_catalogue::TransportCatalogue& catalogue, 
+                               const std::vector<std::pair<BusId, int>>& buses_palette){    
     std::vector<geo::Coordinates> stops_geo_coords;
     bool bus_empty = true; 
     
     for (auto [bus, palette] : buses_palette) {  
+        const std::string bus_name(catalogue.GetBusName(bus));
         
-        for (Stop* stop : bus->stops) {
-            geo::Coordinates coordinates;
-            coordinates.latitude = stop->latitude;
-            coordinates.longitude = stop->longitude;
-            
-            stops_geo_coords.push_back(coordinates); 
+        for (StopId stop : catalogue.GetBusStops(bus)) {
+            stops_geo_coords.push_back(catalogue.GetStopCoordinates(stop)); 
             
             if(bus_empty) bus_empty = false;
         }
@@ -193,38 +188,38 @@ void MapRenderer::AddBusesName(std::vector<std::pair<Bus*, int>>& buses_palette)
         
         if (!bus_empty) {
             
-            if (bus->is_roundtrip) {
+            if (catalogue.IsRoundtrip(bus)) {
                 SetRouteTextAdditionalProperties(route_name_roundtrip,
-                                                     std::string(bus->name),
+                                                     bus_name,
                                                      sphere_projector(stops_geo_coords[0]));
                 map_svg.Add(route_name_roundtrip);
                 
                 SetRouteTextColorProperties(route_title_roundtrip,
-                                                std::string(bus->name),
+                                                bus_name,
                                                 palette,
                                                 sphere_projector(stops_geo_coords[0]));
                 map_svg.Add(route_title_roundtrip);
                 
             } else {
                 SetRouteTextAdditionalProperties(route_name_roundtrip,
-                                                     std::string(bus->name),
+                                                     bus_name,
                                                      sphere_projector(stops_geo_coords[0]));
                 map_svg.Add(route_name_roundtrip);
                 
                 SetRouteTextColorProperties(route_title_roundtrip,
-                                                std::string(bus->name),
+                                                bus_name,
                                                 palette,
                                                 sphere_projector(stops_geo_coords[0]));
                 map_svg.Add(route_title_roundtrip);
                 
                 if (stops_geo_coords[0] != stops_geo_coords[stops_geo_coords.size()/2]) {
                     SetRouteTextAdditionalProperties(route_name_notroundtrip,
-                                                         std::string(bus->name),
+                                                         bus_name,
                                                          sphere_projector(stops_geo_coords[stops_geo_coords.size()/2]));
                     map_svg.Add(route_name_notroundtrip);
                     
                     SetRouteTextColorProperties(route_title_notroundtrip,
-                                                    std::string(bus->name),
+                                                    bus_name,
                                                     palette,
                                                     sphere_projector(stops_geo_coords[stops_geo_coords.size()/2]));
                     map_svg.Add(route_title_notroundtrip);
@@ -237,46 +232,34 @@ void MapRenderer::AddBusesName(std::vector<std::pair<Bus*, int>>& buses_palette)
     }
 }
     
-void MapRenderer::AddStopsCircle(std::vector<Stop*>& stops){
-    std::vector<geo::Coordinates> stops_geo_coords;      
+void MapRenderer::AddStopsCircle(const transport_catalogue::TransportCatalogue& catalogue, 
+                                 const std::vector<StopId>& stops){
     svg::Circle icon;
     
-    for (Stop* stop_info : stops) { 
-        
-        if (stop_info) {
-            geo::Coordinates coordinates;
-            coordinates.latitude = stop_info->latitude;
-            coordinates.longitude = stop_info->longitude; 
- 
-            SetStopsCirclesProperties(icon, sphere_projector(coordinates));
-            map_svg.Add(icon);  
-        }
+    for (StopId stop : stops) { 
+        SetStopsCirclesProperties(icon, sphere_projector(catalogue.GetStopCoordinates(stop)));
+        map_svg.Add(icon);  
     }
 }
   
-void MapRenderer::AddStopsName(std::vector<Stop*>& stops){    
-    std::vector<geo::Coordinates> stops_geo_coords;    
-    
+void MapRenderer::AddStopsName(const transport_catalogue::TransportCatalogue& catalogue, 
+                               const std::vector<StopId>& stops){    
     svg::Text svg_stop_name;
     svg::Text svg_stop_name_title;
     
-    for (Stop* stop_info : stops) {
-        
-        if (stop_info) {
-            geo::Coordinates coordinates;
-            coordinates.latitude = stop_info->latitude;
-            coordinates.longitude = stop_info->longitude;            
+    for (StopId stop : stops) {
+        const std::string stop_name(catalogue.GetStopName(stop));
+        const geo::Coordinates& coordinates = catalogue.GetStopCoordinates(stop);
             
-            SetStopsTextAdditionalProperties(svg_stop_name, 
-                                                 stop_info->name, 
-                                                 sphere_projector(coordinates));
-            map_svg.Add(svg_stop_name);
+        SetStopsTextAdditionalProperties(svg_stop_name, 
+                                             stop_name, 
+                                             sphere_projector(coordinates));
+        map_svg.Add(svg_stop_name);
             
-            SetStopsTextColorProperties(svg_stop_name_title, 
-                                            stop_info->name, 
-                                            sphere_projector(coordinates));
-            map_svg.Add(svg_stop_name_title); 
-        }
+        SetStopsTextColorProperties(svg_stop_name_title, 
+                                        stop_name, 
+                                        sphere_projector(coordinates));
+        map_svg.Add(svg_stop_name_title); 
     }
 }
   
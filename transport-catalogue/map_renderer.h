@@ -8,6 +8,7 @@
 #include "domain.h"
 #include "geo.h"
 #include "svg.h"
+#include "transport_catalogue.h"
  
 using namespace domain;
  
@@ -76,10 +77,14 @@ public:
     void SetStopsTextAdditionalProperties(svg::Text& text, const std::string& name, svg::Point position) const;
     void SetStopsTextColorProperties(svg::Text& text, const std::string& name, svg::Point position) const;
     
-    void AddLine(std::vector<std::pair<Bus*, int>>& buses_palette);
-    void AddBusesName(std::vector<std::pair<Bus*, int>>& buses_palette);
-    void AddStopsCircle(std::vector<Stop*>& stops_name);
-    void AddStopsName(std::vector<Stop*>& stops_name);    
+    void AddLine(const transport_catalogue::TransportCatalogue& catalogue, 
+                 const std::vector<std::pair<BusId, int>>& buses_palette);
+    void AddBusesName(const transport_catalogue::TransportCatalogue& catalogue, 
+                      const std::vector<std::pair<BusId, int>>& buses_palette);
+    void AddStopsCircle(const transport_catalogue::TransportCatalogue& catalogue, 
+                        const std::vector<StopId>& stops);
+    void AddStopsName(const transport_catalogue::TransportCatalogue& catalogue, 
+                      const std::vector<StopId>& stops);    
     
     void GetStreamMap(std::ostream& stream_);
     
@@ -0,0 +1,195 @@
+#include "name_index.h"
+ 
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+ 
+namespace transport_catalogue {
+ 
+NameTable::NameTable() : offsets_(std::vector<uint64_t>{0}) {}
+ 
+NameTable::NameTable(Table<char>&& chars, Table<uint64_t>&& offsets) : chars_(std::move(chars))
+                                                                     , offsets_(std::move(offsets)) {}
+ 
+void NameTable::Add(std::string_view name) {
+    chars_.append(name.begin(), name.end());
+    offsets_.push_back(chars_.size());
+}
+ 
+std::string_view NameTable::operator[](size_t id) const {
+    return {chars_.data() + offsets_[id], static_cast<size_t>(offsets_[id + 1] - offsets_[id])};
+}
+ 
+size_t NameTable::size() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+ 
+const Table<char>& NameTable::GetChars() const {
+    return chars_;
+}
+ 
+const Table<uint64_t>& NameTable::GetOffsets() const {
+    return offsets_;
+}
+ 
+NameIndex::NameIndex(Table<uint32_t>&& seeds, Table<uint32_t>&& slots) : seeds_(std::move(seeds))
+                                                                       , slots_(std::move(slots)) {}
+ 
+void NameIndex::Build(const NameTable& names) {
+    Clear();
+    
+    std::vector<uint32_t> ids(names.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    
+    std::vector<uint64_t> hashes(names.size());
+    
+    for (uint32_t id = 0; id < names.size(); ++id) {
+        hashes[id] = Hash(names[id]);
+    }
+    
+    // equal names would never land in different slots, so only the first id of a name is indexed
+    std::sort(ids.begin(), ids.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return std::make_tuple(hashes[lhs], names[lhs], lhs) < std::make_tuple(hashes[rhs], names[rhs], rhs);
+    });
+    
+    ids.erase(std::unique(ids.begin(), ids.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return names[lhs] == names[rhs];
+    }), ids.end());
+    
+    if (ids.empty()) {
+        return;
+    }
+    
+    for (size_t buckets_count = ids.size() / 4 + 1; !TryBuild(ids, hashes, buckets_count); buckets_count *= 2) {
+    
+        if (buckets_count > 4 * ids.size()) {
+            throw std::runtime_error("cannot build perfect hash for names");
+        }
+    }
+}
+ 
+void NameIndex::Clear() {
+    seeds_ = {};
+    slots_ = {};
+}
+ 
+std::optional<uint32_t> NameIndex::Find(std::string_view name, const NameTable& names) const {
+ 
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    
+    const uint64_t hash = Hash(name);
+    const uint32_t id = slots_[GetSlot(hash, seeds_[(hash >> 32) % seeds_.size()], slots_.size())];
+    
+    if (id < names.size() && names[id] == name) {
+        return id;
+    } else {
+        return std::nullopt;
+    }
+}
+ 
+bool NameIndex::empty() const {
+    return slots_.empty();
+}
+ 
+const Table<uint32_t>& NameIndex::GetSeeds() const {
+    return seeds_;
+}
+ 
+const Table<uint32_t>& NameIndex::GetSlots() const {
+    return slots_;
+}
+ 
+uint64_t NameIndex::Hash(std::string_view name) {
+    // FNV-1a, its high bits barely differ for names like "Bus1" and "Bus2",
+    // so they are mixed once more before choosing a bucket
+    uint64_t hash = 14695981039346656037ULL;
+    
+    for (const char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
+    
+    hash = (hash ^ (hash >> 33)) * 0xff51afd7ed558ccdULL;
+    return hash ^ (hash >> 33);
+}
+ 
+size_t NameIndex::GetSlot(uint64_t hash, uint32_t seed, size_t slots_count) {
+    // splitmix64 finalizer over the name hash displaced by the bucket's seed
+    uint64_t key = hash + seed * 0x9e3779b97f4a7c15ULL;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return (key ^ (key >> 31)) % slots_count;
+}
+ 
+bool NameIndex::TryBuild(const std::vector<uint32_t>& ids,
+                         const std::vector<uint64_t>& hashes,
+                         size_t buckets_count) {
+    
+    // hash and displace: the biggest buckets pick their seeds first, while most slots are still free
+    std::vector<std::vector<uint32_t>> buckets(buckets_count);
+    
+    for (const uint32_t id : ids) {
+        buckets[(hashes[id] >> 32) % buckets_count].push_back(id);
+    }
+    
+    std::vector<uint32_t> bucket_order(buckets_count);
+    std::iota(bucket_order.begin(), bucket_order.end(), 0);
+    
+    std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](uint32_t lhs, uint32_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+    
+    const size_t slots_count = ids.size();
+    std::vector<bool> taken(slots_count, false);
+    std::vector<size_t> bucket_slots;
+    
+    std::vector<uint32_t> seeds(buckets_count, 0);
+    std::vector<uint32_t> slots(slots_count, 0);
+    
+    for (const uint32_t bucket : bucket_order) {
+    
+        if (buckets[bucket].empty()) {
+            break;
+        }
+        
+        uint32_t seed = 0;
+        
+        for (; seed < MAX_SEED; ++seed) {
+            bucket_slots.clear();
+            
+            for (const uint32_t id : buckets[bucket]) {
+                const size_t slot = GetSlot(hashes[id], seed, slots_count);
+                
+                if (taken[slot] || std::find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end()) {
+                    break;
+                }
+                
+                bucket_slots.push_back(slot);
+            }
+            
+            if (bucket_slots.size() == buckets[bucket].size()) {
+                break;
+            }
+        }
+        
+        if (seed == MAX_SEED) {
+            return false;
+        }
+        
+        seeds[bucket] = seed;
+        
+        for (size_t i = 0; i < bucket_slots.size(); ++i) {
+            taken[bucket_slots[i]] = true;
+            slots[bucket_slots[i]] = buckets[bucket][i];
+        }
+    }
+    
+    seeds_ = std::move(seeds);
+    slots_ = std::move(slots);
+    
+    return true;
+}
+ 
+} // namespace transport_catalogue
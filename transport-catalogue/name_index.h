@@ -0,0 +1,67 @@
+#pragma once
+ 
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+ 
+#include "table.h"
+ 
+namespace transport_catalogue {
+ 
+// names by id packed one after another: name id is chars[offsets[id]..offsets[id + 1]),
+// both tables are plain data, so a saved name table is read in place
+class NameTable {
+public:
+    NameTable();
+    NameTable(Table<char>&& chars, Table<uint64_t>&& offsets);
+    
+    // the views handed out earlier may move with the characters
+    void Add(std::string_view name);
+    
+    std::string_view operator[](size_t id) const;
+    size_t size() const;
+    
+    const Table<char>& GetChars() const;
+    const Table<uint64_t>& GetOffsets() const;
+ 
+private:
+    Table<char> chars_;
+    Table<uint64_t> offsets_;
+};
+ 
+// minimal perfect hash over a fixed set of names, built once the names stop changing;
+// a lookup is one string hash, one seed read and one string compare.
+// slots hold ids only, so the index is plain data and is saved and read in place like the names
+class NameIndex {
+public:
+    NameIndex() = default;
+    NameIndex(Table<uint32_t>&& seeds, Table<uint32_t>&& slots);
+    
+    // names[id] is the name of id, of equal names the smallest id is kept
+    void Build(const NameTable& names);
+    void Clear();
+    
+    // names must be the table the index was built over
+    std::optional<uint32_t> Find(std::string_view name, const NameTable& names) const;
+    
+    bool empty() const;
+ 
+    const Table<uint32_t>& GetSeeds() const;
+    const Table<uint32_t>& GetSlots() const;
+ 
+private:
+    static constexpr uint32_t MAX_SEED = 1 << 20;
+    
+    static uint64_t Hash(std::string_view name);
+    static size_t GetSlot(uint64_t hash, uint32_t seed, size_t slots_count);
+    
+    bool TryBuild(const std::vector<uint32_t>& ids,
+                  const std::vector<uint64_t>& hashes,
+                  size_t buckets_count);
+    
+    Table<uint32_t> seeds_;
+    Table<uint32_t> slots_;
+};
+ 
+} // namespace transport_catalogue
@@ -1,5 +1,6 @@
 #pragma once
  
+#include <cstddef>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -12,15 +13,19 @@ class Range {
 public:
     using ValueType = typename std::iterator_traits<It>::value_type;
  
+    Range() = default;
     Range(It begin, It end) : begin_(begin)
                             , end_(end) {}
                             
     It begin() const {return begin_;}
     It end() const {return end_;}
  
+    size_t size() const {return std::distance(begin_, end_);}
+    bool empty() const {return begin_ == end_;}
+ 
 private:
-    It begin_;
-    It end_;
+    It begin_{};
+    It end_{};
 };
  
 template <typename C>
@@ -0,0 +1,185 @@
+#include "raptor_router.h"
+ 
+#include <algorithm>
+ 
+namespace transport_catalogue {
+namespace detail {
+namespace router {
+ 
+RaptorRouter::RaptorRouter(const TransportCatalogue& transport_catalogue,
+                           double bus_wait_time,
+                           double bus_velocity) : bus_wait_time_(bus_wait_time)
+                                                , bus_velocity_(bus_velocity) {
+    
+    stop_names_.reserve(transport_catalogue.GetStopsCount());
+    
+    for (StopId stop = 0; stop < transport_catalogue.GetStopsCount(); ++stop) {
+        stop_names_.push_back(transport_catalogue.GetStopName(stop));
+    }
+    
+    bus_offsets_.push_back(0);
+    
+    for (BusId bus = 0; bus < transport_catalogue.GetBusesCount(); ++bus) {
+    
+        if (transport_catalogue.GetBusStopsCount(bus) < 2) {
+            continue;
+        }
+        
+        const auto stops = transport_catalogue.GetBusStops(bus);
+        const auto distances = transport_catalogue.GetBusDistances(bus);
+        
+        bus_names_.push_back(transport_catalogue.GetBusName(bus));
+        bus_stops_.insert(bus_stops_.end(), stops.begin(), stops.end());
+        bus_distances_.insert(bus_distances_.end(), distances.begin(), distances.end());
+        
+        bus_offsets_.push_back(bus_stops_.size());
+    }
+    
+    stop_offsets_.assign(stop_names_.size() + 1, 0);
+    
+    for (const uint32_t stop : bus_stops_) {
+        ++stop_offsets_[stop + 1];
+    }
+    
+    for (size_t stop = 0; stop < stop_names_.size(); ++stop) {
+        stop_offsets_[stop + 1] += stop_offsets_[stop];
+    }
+    
+    std::vector<uint32_t> stop_fill(stop_offsets_.begin(), std::prev(stop_offsets_.end()));
+    stop_buses_.resize(bus_stops_.size());
+    
+    for (uint32_t bus = 0; bus + 1 < bus_offsets_.size(); ++bus) {
+    
+        for (uint32_t i = bus_offsets_[bus]; i < bus_offsets_[bus + 1]; ++i) {
+            stop_buses_[stop_fill[bus_stops_[i]]++] = StopOnBus{bus, i - bus_offsets_[bus]};
+        }
+    }
+}
+ 
+double RaptorRouter::GetRideTime(uint32_t bus, uint32_t board_position, uint32_t alight_position) const {
+    const uint32_t begin = bus_offsets_[bus];
+    return static_cast<double>(bus_distances_[begin + alight_position] - bus_distances_[begin + board_position]) / bus_velocity_;
+}
+ 
+RaptorRouter::SearchState RaptorRouter::Search(size_t from, std::optional<size_t> target) const {
+    SearchState state{std::vector<double>(stop_names_.size(), INFINITE_TIME),
+                      std::vector<Leg>(stop_names_.size()),
+                      std::vector<bool>(stop_names_.size(), false),
+                      std::vector<uint32_t>(bus_names_.size(), NONE)};
+    
+    auto& arrivals = state.arrivals;
+    auto& marked_stops = state.marked_stops;
+    auto& first_marked_positions = state.first_marked_positions;
+    
+    std::vector<uint32_t> marked_list{static_cast<uint32_t>(from)};
+    std::vector<uint32_t> queued_buses;
+    
+    arrivals.at(from) = 0.;
+    marked_stops[from] = true;
+    
+    // each round rides every bus touched by the stops improved in the previous one
+    while (!marked_list.empty()) {
+    
+        for (const uint32_t stop : marked_list) {
+            marked_stops[stop] = false;
+            
+            for (uint32_t i = stop_offsets_[stop]; i < stop_offsets_[stop + 1]; ++i) {
+                const auto [bus, position] = stop_buses_[i];
+                
+                if (first_marked_positions[bus] == NONE) {
+                    queued_buses.push_back(bus);
+                    first_marked_positions[bus] = position;
+                } else {
+                    first_marked_positions[bus] = std::min(first_marked_positions[bus], position);
+                }
+            }
+        }
+        
+        marked_list.clear();
+        
+        for (const uint32_t bus : queued_buses) {
+            const uint32_t begin = bus_offsets_[bus];
+            const uint32_t stops_count = bus_offsets_[bus + 1] - begin;
+            
+            double board_time = INFINITE_TIME;
+            uint32_t board_position = 0;
+            
+            for (uint32_t position = first_marked_positions[bus]; position < stops_count; ++position) {
+                const uint32_t stop = bus_stops_[begin + position];
+                double arrival = INFINITE_TIME;
+                
+                if (board_time != INFINITE_TIME) {
+                    arrival = board_time + GetRideTime(bus, board_position, position);
+                    const double bound = target ? arrivals[*target] : INFINITE_TIME;
+                    
+                    if (arrival < arrivals[stop] && arrival < bound) {
+                        arrivals[stop] = arrival;
+                        state.legs[stop] = Leg{bus, board_position, position};
+                        
+                        if (!marked_stops[stop]) {
+                            marked_stops[stop] = true;
+                            marked_list.push_back(stop);
+                        }
+                    }
+                }
+                
+                if (arrivals[stop] != INFINITE_TIME && arrivals[stop] + bus_wait_time_ < arrival) {
+                    board_time = arrivals[stop] + bus_wait_time_;
+                    board_position = position;
+                }
+            }
+            
+            first_marked_positions[bus] = NONE;
+        }
+        
+        queued_buses.clear();
+    }
+    
+    return state;
+}
+ 
+std::optional<RouteInfo> RaptorRouter::ExtractRoute(size_t to, const SearchState& state) const {
+ 
+    if (state.arrivals.at(to) == INFINITE_TIME) {
+        return std::nullopt;
+    }
+    
+    RouteInfo route_info;
+    route_info.total_time = state.arrivals[to];
+    
+    for (size_t stop = to; state.legs[stop].bus != NONE;) {
+        const Leg& leg = state.legs[stop];
+        
+        route_info.edges.emplace_back(BusEdge{bus_names_[leg.bus],
+                                              leg.alight_position - leg.board_position,
+                                              GetRideTime(leg.bus, leg.board_position, leg.alight_position)});
+        
+        stop = bus_stops_[bus_offsets_[leg.bus] + leg.board_position];
+        route_info.edges.emplace_back(StopEdge{stop_names_[stop], bus_wait_time_});
+    }
+    
+    std::reverse(route_info.edges.begin(), route_info.edges.end());
+    
+    return route_info;
+}
+ 
+std::optional<RouteInfo> RaptorRouter::Build_route(StopId from, StopId to) const {
+    return ExtractRoute(to, Search(from, to));
+}
+ 
+std::vector<std::optional<RouteInfo>> RaptorRouter::Build_routes(StopId from, const std::vector<StopId>& to) const {
+    const SearchState state = Search(from, std::nullopt);
+    
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(to.size());
+    
+    for (const size_t stop : to) {
+        routes.push_back(ExtractRoute(stop, state));
+    }
+    
+    return routes;
+}
+ 
+} // namespace router
+} // namespace detail
+} // namespace transport_catalogue
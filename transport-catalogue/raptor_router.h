@@ -0,0 +1,75 @@
+#pragma once
+ 
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+ 
+#include "domain.h"
+#include "transport_catalogue.h"
+ 
+namespace transport_catalogue {
+namespace detail {
+namespace router {
+ 
+using namespace domain;
+ 
+// round-based search straight over the buses' stop sequences, no per-bus edge expansion;
+// stops are addressed by their catalogue ids
+class RaptorRouter {
+public:
+    // bus_velocity is in meters per minute
+    RaptorRouter(const TransportCatalogue& transport_catalogue,
+                 double bus_wait_time,
+                 double bus_velocity);
+    
+    std::optional<RouteInfo> Build_route(StopId from, StopId to) const;
+    std::vector<std::optional<RouteInfo>> Build_routes(StopId from, const std::vector<StopId>& to) const;
+ 
+private:
+    static constexpr double INFINITE_TIME = std::numeric_limits<double>::max();
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    
+    // the bus ride that set a stop's best arrival, positions index the bus' stop sequence
+    struct Leg {
+        uint32_t bus = NONE;
+        uint32_t board_position = 0;
+        uint32_t alight_position = 0;
+    };
+    
+    struct SearchState {
+        std::vector<double> arrivals;
+        std::vector<Leg> legs;
+        std::vector<bool> marked_stops;
+        std::vector<uint32_t> first_marked_positions;
+    };
+    
+    struct StopOnBus {
+        uint32_t bus;
+        uint32_t position;
+    };
+    
+    SearchState Search(size_t from, std::optional<size_t> target) const;
+    std::optional<RouteInfo> ExtractRoute(size_t to, const SearchState& state) const;
+    
+    double GetRideTime(uint32_t bus, uint32_t board_position, uint32_t alight_position) const;
+    
+    double bus_wait_time_;
+    double bus_velocity_;
+    
+    std::vector<std::string_view> stop_names_;
+    std::vector<std::string_view> bus_names_;
+    
+    // every bus' stop sequence and distance prefix sums, packed one after another
+    std::vector<uint32_t> bus_offsets_;
+    std::vector<uint32_t> bus_stops_;
+    std::vector<size_t> bus_distances_;
+    
+    std::vector<uint32_t> stop_offsets_;
+    std::vector<StopOnBus> stop_buses_;
+};
+ 
+} // namespace router
+} // namespace detail
+} // namespace transport_catalogue
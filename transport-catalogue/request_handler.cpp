@@ -1,5 +1,8 @@
 #include "request_handler.h"
  
+#include <atomic>
+#include <thread>
+ 
 namespace request_handler {
  
 struct EdgeInfoGetter {
@@ -28,9 +31,10 @@ struct EdgeInfoGetter {
     }
 };
  
-Node RequestHandler::ExecuteMakeNodeStop(int id_request, const StopQueryResult& stop_info) {
+Node RequestHandler::ExecuteMakeNodeStop(int id_request, 
+                                            const StopQueryResult& stop_info, 
+                                            const TransportCatalogue& catalogue) {
     Node result;
-    Array buses;
     transport_catalogue::detail::json::Builder::Builder Builder;
  
     std::string str_not_found = "not found";
@@ -48,8 +52,8 @@ Node RequestHandler::ExecuteMakeNodeStop(int id_request, const StopQueryResult&
                .Key("request_id").Value(id_request)
                .Key("buses").StartArray();
  
-        for (std::string bus_name : stop_info.buses_name) {
-            Builder.Value(bus_name);
+        for (BusId bus : stop_info.buses) {
+            Builder.Value(std::string(catalogue.GetBusName(bus)));
         }
  
         Builder.EndArray().EndDict();
@@ -84,21 +88,91 @@ Node RequestHandler::ExecuteMakeNodeBus(int id_request, const BusQueryResult& bu
     return result;
 }
  
+Node RequestHandler::ExecuteMakeNodeNearbyStops(int id_request, 
+                                                   const std::vector<NearbyStop>& stops, 
+                                                   const TransportCatalogue& catalogue) {
+    Array items;
+    items.reserve(stops.size());
+ 
+    for (const NearbyStop& stop : stops) {
+        items.emplace_back(transport_catalogue::detail::json::Builder::Builder{}.StartDict()
+                                .Key("name").Value(std::string(catalogue.GetStopName(stop.stop)))
+                                .Key("distance").Value(stop.distance)
+                                .EndDict()
+                                .Build());
+    }
+ 
+    return transport_catalogue::detail::json::Builder::Builder{}.StartDict()
+                    .Key("request_id").Value(id_request)
+                    .Key("stops").Value(std::move(items))
+                    .EndDict()
+                    .Build();
+}
+ 
+Node RequestHandler::ExecuteMakeNodeDirectConnection(const StatRequest& request, const TransportCatalogue& catalogue) {
+    const auto stop_from = catalogue.GetStop(request.from);
+    const auto stop_to = catalogue.GetStop(request.to);
+ 
+    if (!stop_from || !stop_to) {
+        return transport_catalogue::detail::json::Builder::Builder{}.StartDict()
+                        .Key("request_id").Value(request.id)
+                        .Key("error_message").Value("not found")
+                        .EndDict()
+                        .Build();
+    }
+ 
+    Array items;
+ 
+    for (const DirectConnection& connection : catalogue.FindDirectConnections(*stop_from, *stop_to)) {
+        items.emplace_back(transport_catalogue::detail::json::Builder::Builder{}.StartDict()
+                                .Key("bus").Value(std::string(catalogue.GetBusName(connection.bus)))
+                                .Key("span_count").Value(static_cast<int>(connection.span_count))
+                                .Key("distance").Value(static_cast<int>(connection.distance))
+                                .EndDict()
+                                .Build());
+    }
+ 
+    return transport_catalogue::detail::json::Builder::Builder{}.StartDict()
+                    .Key("request_id").Value(request.id)
+                    .Key("buses").Value(std::move(items))
+                    .EndDict()
+                    .Build();
+}
+ 
+Node RequestHandler::ExecuteMakeNodeSuggest(int id_request, 
+                                               std::string_view prefix, 
+                                               size_t limit, 
+                                               const TransportCatalogue& catalogue) {
+    const auto stops = catalogue.FindStopsByPrefix(prefix);
+    const auto buses = catalogue.FindBusesByPrefix(prefix);
+ 
+    Array stop_names;
+    Array bus_names;
+ 
+    for (auto it = stops.begin(); it != stops.end() && stop_names.size() < limit; ++it) {
+        stop_names.emplace_back(std::string(catalogue.GetStopName(*it)));
+    }
+ 
+    for (auto it = buses.begin(); it != buses.end() && bus_names.size() < limit; ++it) {
+        bus_names.emplace_back(std::string(catalogue.GetBusName(*it)));
+    }
+ 
+    return transport_catalogue::detail::json::Builder::Builder{}.StartDict()
+                    .Key("request_id").Value(id_request)
+                    .Key("stops").Value(std::move(stop_names))
+                    .Key("buses").Value(std::move(bus_names))
+                    .EndDict()
+                    .Build();
+}
+ 
 Node RequestHandler::ExecuteMakeNodeMap(int id_request, 
                                            TransportCatalogue& catalogue_, 
-                                           RenderSettings render_settings) {
+                                           RenderSettings render_settings, 
+                                           std::string_view rendered_map) {
     Node result;
  
-    std::ostringstream map_stream;
-    std::string map_str;
- 
-    MapRenderer map_catalogue(render_settings);
-    
-    map_catalogue.InitSphereProjector(GetStopsCoordinates(catalogue_));
-    
-    ExecuteRenderMap(map_catalogue, catalogue_);
-    map_catalogue.GetStreamMap(map_stream);
-    map_str = map_stream.str();
+    std::string map_str = rendered_map.empty() ? RenderMap(catalogue_, std::move(render_settings)) 
+                                               : std::string(rendered_map);
  
     result = transport_catalogue::detail::json::Builder::Builder{}.StartDict()
                       .Key("request_id").Value(id_request)
@@ -109,65 +183,248 @@ Node RequestHandler::ExecuteMakeNodeMap(int id_request,
     return result;
 }
  
-Node RequestHandler::ExecuteMakeNodeRoute(StatRequest& request, 
-                                             TransportCatalogue& catalogue, 
-                                             TransportRouter& routing) {
-    const auto& route_info = GetRouteInfo(request.from, request.to, catalogue, routing);
+Node RequestHandler::ExecuteMakeNodeRoute(int id_request, const std::optional<RouteInfo>& route_info) const {
+    return ExecuteMakeNodeRoute(id_request, MakeCachedRoute(route_info));
+}
  
-    if (!route_info) {
+Node RequestHandler::ExecuteMakeNodeRoute(int id_request, const CachedRoute& cached_route) const {
+ 
+    if (!cached_route.route_info) {
         return transport_catalogue::detail::json::Builder::Builder{}.StartDict()
-                        .Key("request_id").Value(request.id)
+                        .Key("request_id").Value(id_request)
                         .Key("error_message").Value("not found")
                         .EndDict()
                         .Build();
     }
  
+    return transport_catalogue::detail::json::Builder::Builder{}.StartDict()
+                    .Key("request_id").Value(id_request)
+                    .Key("total_time").Value(cached_route.route_info->total_time)
+                    .Key("items").Value(cached_route.items.AsArray())
+                    .EndDict()
+                    .Build();
+}
+ 
+CachedRoute RequestHandler::MakeCachedRoute(const std::optional<RouteInfo>& route_info) const {
+    
+    if (!route_info) {
+        return {std::nullopt, Node{}};
+    }
+    
     Array items;
+    items.reserve(route_info->edges.size());
+    
     for (const auto& item : route_info->edges) {
         items.emplace_back(std::visit(EdgeInfoGetter{}, item));
     }
+    
+    return {route_info, Node(std::move(items))};
+}
  
-    return transport_catalogue::detail::json::Builder::Builder{}.StartDict()
-                    .Key("request_id").Value(request.id)
-                    .Key("total_time").Value(route_info->total_time)
-                    .Key("items").Value(items)
-                    .EndDict()
-                    .Build();
+void RequestHandler::ExecuteRouteQueries(const std::vector<StatRequest>& stat_requests, 
+                                           const std::vector<size_t>& route_requests, 
+                                           TransportCatalogue& catalogue, 
+                                           TransportRouter& routing, 
+                                           std::vector<Node>& result_request) const {
+    
+    struct RouteSource {
+        StopId stop_from;
+        VertexId start;
+        // distinct targets, each with every request asking for it
+        std::vector<StopId> stops_to;
+        std::vector<VertexId> ends;
+        std::vector<std::vector<size_t>> requests;
+        std::unordered_map<StopId, size_t> stop_to_target;
+    };
+    
+    std::vector<RouteSource> sources;
+    std::unordered_map<StopId, size_t> stop_to_source;
+    
+    RouteCache& route_cache = routing.GetRouteCache();
+    
+    for (const size_t request_index : route_requests) {
+        const StatRequest& request = stat_requests[request_index];
+        
+        const auto stop_from = catalogue.GetStop(request.from);
+        const auto stop_to = catalogue.GetStop(request.to);
+        
+        if (!stop_from || !stop_to) {
+            result_request[request_index] = ExecuteMakeNodeRoute(request.id, std::nullopt);
+            continue;
+        }
+        
+        const RouterByStop router_from = routing.GetRouterByStop(*stop_from);
+        const RouterByStop router_to = routing.GetRouterByStop(*stop_to);
+        
+        if (const auto cached_route = route_cache.Find(*stop_from, *stop_to)) {
+            result_request[request_index] = ExecuteMakeNodeRoute(request.id, *cached_route);
+            continue;
+        }
+        
+        const auto [it, inserted] = stop_to_source.emplace(*stop_from, sources.size());
+        if (inserted) {
+            sources.push_back({*stop_from, router_from.bus_wait_start, {}, {}, {}, {}});
+        }
+        
+        RouteSource& source = sources[it->second];
+        const auto [target, new_target] = source.stop_to_target.emplace(*stop_to, source.stops_to.size());
+        
+        if (new_target) {
+            source.stops_to.push_back(*stop_to);
+            source.ends.push_back(router_to.bus_wait_start);
+            source.requests.emplace_back();
+        }
+        
+        source.requests[target->second].push_back(request_index);
+    }
+    
+    // one shortest-path tree per distinct origin, origins are spread over the worker threads
+    std::atomic<size_t> next_source = 0;
+    
+    auto execute_sources = [&]() {
+        
+        for (size_t source_index = next_source++; source_index < sources.size(); source_index = next_source++) {
+            const RouteSource& source = sources[source_index];
+            const auto routes_info = routing.GetRoutesInfo(source.start, source.ends);
+            
+            for (size_t i = 0; i < source.stops_to.size(); ++i) {
+                CachedRoute cached_route = MakeCachedRoute(routes_info[i]);
+                
+                for (const size_t request_index : source.requests[i]) {
+                    result_request[request_index] = ExecuteMakeNodeRoute(stat_requests[request_index].id, cached_route);
+                }
+                
+                route_cache.Insert(source.stop_from, source.stops_to[i], std::move(cached_route));
+            }
+        }
+    };
+    
+    const size_t threads_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), sources.size());
+    std::vector<std::thread> workers;
+    
+    for (size_t thread = 1; thread < threads_count; ++thread) {
+        workers.emplace_back(execute_sources);
+    }
+    
+    execute_sources();
+    
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+ 
+void RequestHandler::WarmRouteCache(TransportCatalogue& catalogue, 
+                                     const std::vector<StatRequest>& stat_requests, 
+                                     TransportRouter& transport_router) const {
+    
+    std::vector<Node> result_request(stat_requests.size());
+    std::vector<size_t> route_requests;
+    
+    for (size_t i = 0; i < stat_requests.size(); ++i) {
+        if (stat_requests[i].type == "Route") {
+            route_requests.push_back(i);
+        }
+    }
+    
+    if (!route_requests.empty()) {
+        RequireSection(BaseSection::ROUTER);
+    }
+    
+    ExecuteRouteQueries(stat_requests, route_requests, catalogue, transport_router, result_request);
+    transport_router.GetRouteCache().ResetStats();
+}
+ 
+void RequestHandler::SetSectionLoader(std::function<void(BaseSection)> section_loader) {
+    section_loader_ = std::move(section_loader);
+}
+ 
+void RequestHandler::RequireSection(BaseSection section) const {
+    
+    if (section_loader_) {
+        section_loader_(section);
+    }
 }
  
 void RequestHandler::ExecuteQueries(TransportCatalogue& catalogue,
                                      std::vector<StatRequest>& stat_requests,
                                      RenderSettings& render_settings,
-                                     RoutingSettings& routing_settings) {
+                                     const std::string& rendered_map,
+                                     TransportRouter& transport_router) {
  
-    std::vector<Node> result_request;
-    TransportRouter transport_router;
-    
-    transport_router.SetRoutingSettings(routing_settings);
-    transport_router.BuildRouter(catalogue);
+    std::vector<Node> result_request(stat_requests.size());
+    std::vector<size_t> route_requests;
     
-    for (StatRequest req : stat_requests) {
+    for (size_t i = 0; i < stat_requests.size(); ++i) {
+        const StatRequest& req = stat_requests[i];
  
         if (req.type == "Stop") {
-            result_request.push_back(ExecuteMakeNodeStop(req.id, StopQuery(catalogue, req.name)));
+            result_request[i] = ExecuteMakeNodeStop(req.id, StopQuery(catalogue, req.name), catalogue);
             
         } else if (req.type == "Bus") {
-            result_request.push_back(ExecuteMakeNodeBus(req.id, BusQuery(catalogue, req.name)));
+            result_request[i] = ExecuteMakeNodeBus(req.id, BusQuery(catalogue, req.name));
             
         } else if (req.type == "Map") {
-            result_request.push_back(ExecuteMakeNodeMap(req.id, catalogue, render_settings));
+            RequireSection(BaseSection::RENDERED_MAP);
+            
+            // a base saved without its map renders it here
+            if (rendered_map.empty()) {
+                RequireSection(BaseSection::NAME_ORDER);
+                RequireSection(BaseSection::RENDER_SETTINGS);
+            }
+            
+            result_request[i] = ExecuteMakeNodeMap(req.id, catalogue, render_settings, rendered_map);
             
         } else if (req.type == "Route") {
-            result_request.push_back(ExecuteMakeNodeRoute(req, catalogue, transport_router));
+            route_requests.push_back(i);
+            
+        } else if (req.type == "NearestStops") {
+            RequireSection(BaseSection::STOP_GRID);
+            const size_t count = static_cast<size_t>(std::max(req.count, 0));
+            result_request[i] = ExecuteMakeNodeNearbyStops(req.id, catalogue.FindNearestStops(req.point, count), catalogue);
+            
+        } else if (req.type == "StopsInRadius") {
+            RequireSection(BaseSection::STOP_GRID);
+            result_request[i] = ExecuteMakeNodeNearbyStops(req.id, catalogue.FindStopsInRadius(req.point, req.radius), catalogue);
+            
+        } else if (req.type == "DirectConnection") {
+            result_request[i] = ExecuteMakeNodeDirectConnection(req, catalogue);
+            
+        } else if (req.type == "Suggest") {
+            RequireSection(BaseSection::NAME_ORDER);
+            const size_t limit = static_cast<size_t>(std::max(req.limit, 0));
+            result_request[i] = ExecuteMakeNodeSuggest(req.id, req.prefix, limit, catalogue);
         }   
     }
+    
+    if (!route_requests.empty()) {
+        RequireSection(BaseSection::ROUTER);
+    }
+    
+    ExecuteRouteQueries(stat_requests, route_requests, catalogue, transport_router, result_request);
+    
+    result_request.erase(std::remove_if(result_request.begin(), result_request.end(), 
+                                        [](const Node& node) {return node.IsNull();}), 
+                         result_request.end());
  
     doc_out = Document{Node(result_request)};
 }
  
-void RequestHandler::ExecuteRenderMap(MapRenderer& map_catalogue, TransportCatalogue& catalogue) const {
-    std::vector<std::pair<Bus*, int>> buses_palette;
-    std::vector<Stop*> stops_sort;
+std::string RequestHandler::RenderMap(const TransportCatalogue& catalogue, RenderSettings render_settings) const {
+    std::ostringstream map_stream;
+    
+    MapRenderer map_catalogue(render_settings);
+    
+    map_catalogue.InitSphereProjector(GetStopsCoordinates(catalogue));
+    
+    ExecuteRenderMap(map_catalogue, catalogue);
+    map_catalogue.GetStreamMap(map_stream);
+    
+    return map_stream.str();
+}
+ 
+void RequestHandler::ExecuteRenderMap(MapRenderer& map_catalogue, const TransportCatalogue& catalogue) const {
+    std::vector<std::pair<BusId, int>> buses_palette;
+    std::vector<StopId> stops_sort;
     int palette_size = 0;
     int palette_index = 0;
  
@@ -178,115 +435,81 @@ void RequestHandler::ExecuteRenderMap(MapRenderer& map_catalogue, TransportCatal
         return;
     }
  
-    auto buses = catalogue.GetBusNameToBus();
-    if (buses.size() > 0) {
+    if (catalogue.GetBusesCount() > 0) {
  
-        for (std::string_view bus_name : GetSortBusesNames(catalogue)) {
-            Bus* bus_info = catalogue.GetBus(bus_name);
+        for (BusId bus : catalogue.GetBusesByName()) {
  
-            if (bus_info) {
-                if (bus_info->stops.size() > 0) {
-                    buses_palette.push_back(std::make_pair(bus_info, palette_index));
-                    palette_index++;
+            if (catalogue.GetBusStopsCount(bus) > 0) {
+                buses_palette.push_back(std::make_pair(bus, palette_index));
+                palette_index++;
  
-                    if (palette_index == palette_size) {
-                        palette_index = 0;
-                    }
+                if (palette_index == palette_size) {
+                    palette_index = 0;
                 }
             }
         }
  
         if (buses_palette.size() > 0) {
-            map_catalogue.AddLine(buses_palette);
-            map_catalogue.AddBusesName(buses_palette);
+            map_catalogue.AddLine(catalogue, buses_palette);
+            map_catalogue.AddBusesName(catalogue, buses_palette);
         }
     }
  
-    auto stops = catalogue.GetStopNameToStop();
-    if (stops.size() > 0) {
-        std::vector<std::string_view> stops_name;
- 
-        for (auto& [stop_name, stop] : stops) {
- 
-            if (stop->buses.size() > 0) {
-                stops_name.push_back(stop_name);
-            }
-        }
+    if (catalogue.GetStopsCount() > 0) {
  
-        std::sort(stops_name.begin(), stops_name.end());
+        for (StopId stop : catalogue.GetStopsByName()) {
  
-        for (std::string_view stop_name : stops_name) {
-            Stop* stop = catalogue.GetStop(stop_name);
-            if (stop) {
+            if (!catalogue.GetStopBuses(stop).empty()) {
                 stops_sort.push_back(stop);
             }
         }
  
         if (stops_sort.size() > 0) {
-            map_catalogue.AddStopsCircle(stops_sort);
-            map_catalogue.AddStopsName(stops_sort);
+            map_catalogue.AddStopsCircle(catalogue, stops_sort);
+            map_catalogue.AddStopsName(catalogue, stops_sort);
         }
     }
 }
  
-std::optional<RouteInfo> RequestHandler::GetRouteInfo(std::string_view start, 
-                                                        std::string_view end, 
-                                                        TransportCatalogue& catalogue, 
-                                                        TransportRouter& routing) const {
- 
-    return routing.GetRouteInfo(routing.GetRouterByStop(catalogue.GetStop(start))->bus_wait_start, 
-                                  routing.GetRouterByStop(catalogue.GetStop(end))->bus_wait_start);
-}
- 
-std::vector<geo::Coordinates> RequestHandler::GetStopsCoordinates(TransportCatalogue& catalogue_) const {
+std::vector<geo::Coordinates> RequestHandler::GetStopsCoordinates(const TransportCatalogue& catalogue_) const {
  
     std::vector<geo::Coordinates> stops_coordinates;
-    auto buses = catalogue_.GetBusNameToBus();
+    const auto coordinates = catalogue_.GetStopsCoordinates();
  
-    for (auto& [busname, bus] : buses) {
+    // only the bounding box matters to the projector, so every stop on a route is taken once
+    for (StopId stop = 0; stop < catalogue_.GetStopsCount(); ++stop) {
         
-        for (auto& stop : bus->stops) {
-            geo::Coordinates coordinates;
-            coordinates.latitude = stop->latitude;
-            coordinates.longitude = stop->longitude;
- 
-            stops_coordinates.push_back(coordinates);
+        if (!catalogue_.GetStopBuses(stop).empty()) {
+            stops_coordinates.push_back(coordinates.begin()[stop]);
         }
     }
     return stops_coordinates;
 }
  
-std::vector<std::string_view> RequestHandler::GetSortBusesNames(TransportCatalogue& catalogue_) const {
+std::vector<std::string_view> RequestHandler::GetSortBusesNames(const TransportCatalogue& catalogue_) const {
     std::vector<std::string_view> buses_names;
+    buses_names.reserve(catalogue_.GetBusesCount());
  
-    auto buses = catalogue_.GetBusNameToBus();
-    if (buses.size() > 0) {
- 
-        for (auto& [busname, bus] : buses) {
-            buses_names.push_back(busname);
-        }
- 
-        std::sort(buses_names.begin(), buses_names.end());
- 
-        return buses_names;
- 
-    } else {
-        return {};
+    for (BusId bus : catalogue_.GetBusesByName()) {
+        buses_names.push_back(catalogue_.GetBusName(bus));
     }
+ 
+    return buses_names;
 }
  
 BusQueryResult RequestHandler::BusQuery(TransportCatalogue& catalogue, std::string_view bus_name) {
     BusQueryResult bus_info;
-    Bus* bus = catalogue.GetBus(bus_name);
+    const auto bus = catalogue.GetBus(bus_name);
  
-    if (bus != nullptr) {
-        bus_info.name = bus->name;
+    if (bus) {
+        bus_info.name = catalogue.GetBusName(*bus);
         bus_info.not_found = false;
-        bus_info.stops_on_route = static_cast<int>(bus->stops.size());
-        bus_info.unique_stops = static_cast<int>(catalogue.GetUniqStops(bus).size());
-        bus_info.route_length = static_cast<int>(bus->route_length);
-        bus_info.curvature = double(catalogue.GetDistanceToBus(bus)
-                                   /catalogue.GetLength(bus));
+        const BusStats& bus_stats = catalogue.GetBusStats(*bus);
+        
+        bus_info.stops_on_route = static_cast<int>(bus_stats.stops_on_route);
+        bus_info.unique_stops = static_cast<int>(bus_stats.unique_stops);
+        bus_info.route_length = static_cast<int>(bus_stats.route_length);
+        bus_info.curvature = bus_stats.curvature;
     } else {
         bus_info.name = bus_name;
         bus_info.not_found = true;
@@ -296,24 +519,13 @@ BusQueryResult RequestHandler::BusQuery(TransportCatalogue& catalogue, std::stri
 }
  
 StopQueryResult RequestHandler::StopQuery(TransportCatalogue& catalogue, std::string_view stop_name) {
-    std::unordered_set<const Bus*> unique_buses;
     StopQueryResult stop_info;
-    Stop* stop = catalogue.GetStop(stop_name);
+    const auto stop = catalogue.GetStop(stop_name);
  
-    if (stop != NULL) {
- 
-        stop_info.name = stop->name;
+    if (stop) {
+        stop_info.name = catalogue.GetStopName(*stop);
         stop_info.not_found = false;
-        unique_buses = catalogue.GetStopUniqBuses(stop);
- 
-        if (unique_buses.size() > 0) {
-            
-            for (const Bus* bus : unique_buses) {
-                stop_info.buses_name.push_back(bus->name);
-            }
- 
-            std::sort(stop_info.buses_name.begin(), stop_info.buses_name.end());
-        }
+        stop_info.buses = catalogue.GetStopBuses(*stop);
         
     } else {
         stop_info.name = stop_name;
@@ -1,8 +1,10 @@
 #pragma once
  
+#include <functional>
+ 
 #include "transport_catalogue.h"
 #include "map_renderer.h"
-#include "json_Builder.h"
+#include "json_builder.h"
 #include "transport_router.h"
  
 using namespace transport_catalogue;
@@ -18,33 +20,55 @@ public:
            
     RequestHandler() = default;
     
-    std::optional<RouteInfo> GetRouteInfo(std::string_view start, 
-                                            std::string_view end, 
-                                            TransportCatalogue& catalogue, 
-                                            TransportRouter& routing) const;
-    
-    std::vector<geo::Coordinates> GetStopsCoordinates(TransportCatalogue& catalogue_) const;
-    std::vector<std::string_view> GetSortBusesNames(TransportCatalogue& catalogue_) const;
+    std::vector<geo::Coordinates> GetStopsCoordinates(const TransportCatalogue& catalogue_) const;
+    std::vector<std::string_view> GetSortBusesNames(const TransportCatalogue& catalogue_) const;
     
     BusQueryResult BusQuery(TransportCatalogue& catalogue, std::string_view str);
     StopQueryResult StopQuery(TransportCatalogue& catalogue, std::string_view stop_name);
     
-    Node ExecuteMakeNodeStop(int id_request, const StopQueryResult& query_result);
+    Node ExecuteMakeNodeStop(int id_request, const StopQueryResult& query_result, const TransportCatalogue& catalogue);
     Node ExecuteMakeNodeBus(int id_request, const BusQueryResult& query_result);
-    Node ExecuteMakeNodeMap(int id_request, TransportCatalogue& catalogue, RenderSettings render_settings);
-    Node ExecuteMakeNodeRoute(StatRequest& request, TransportCatalogue& catalogue, TransportRouter& routing);
+    Node ExecuteMakeNodeNearbyStops(int id_request, const std::vector<NearbyStop>& stops, const TransportCatalogue& catalogue);
+    Node ExecuteMakeNodeDirectConnection(const StatRequest& request, const TransportCatalogue& catalogue);
+    Node ExecuteMakeNodeSuggest(int id_request, std::string_view prefix, size_t limit, const TransportCatalogue& catalogue);
+    // rendered_map is the map saved with the base, the map is rendered anew when it is empty
+    Node ExecuteMakeNodeMap(int id_request, 
+                            TransportCatalogue& catalogue, 
+                            RenderSettings render_settings, 
+                            std::string_view rendered_map);
+    Node ExecuteMakeNodeRoute(int id_request, const std::optional<RouteInfo>& route_info) const;
+    Node ExecuteMakeNodeRoute(int id_request, const CachedRoute& cached_route) const;
+    CachedRoute MakeCachedRoute(const std::optional<RouteInfo>& route_info) const;
+    
+    void ExecuteRouteQueries(const std::vector<StatRequest>& stat_requests, 
+                               const std::vector<size_t>& route_requests, 
+                               TransportCatalogue& catalogue, 
+                               TransportRouter& routing, 
+                               std::vector<Node>& result_request) const;
+    
+    void WarmRouteCache(TransportCatalogue& catalogue, 
+                         const std::vector<StatRequest>& stat_requests, 
+                         TransportRouter& transport_router) const;
+    
+    // called with every section a request reads before the request runs, the loader skips those already loaded
+    void SetSectionLoader(std::function<void(BaseSection)> section_loader);
     
     void ExecuteQueries(TransportCatalogue& catalogue, 
                          std::vector<StatRequest>& stat_requests, 
                          RenderSettings& render_settings,
-                         RoutingSettings& route_settings);
+                         const std::string& rendered_map,
+                         TransportRouter& transport_router);
     
-    void ExecuteRenderMap(MapRenderer& map_catalogue, TransportCatalogue& catalogue_) const;
+    void ExecuteRenderMap(MapRenderer& map_catalogue, const TransportCatalogue& catalogue_) const;
+    std::string RenderMap(const TransportCatalogue& catalogue, RenderSettings render_settings) const;
        
     const Document& GetDocument();
  
 private:
+    void RequireSection(BaseSection section) const;
+    
     Document doc_out;
+    std::function<void(BaseSection)> section_loader_;
 };
     
 } // namespace request_handler
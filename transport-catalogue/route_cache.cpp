@@ -0,0 +1,75 @@
+#include "route_cache.h"
+ 
+namespace transport_catalogue {
+namespace detail {
+namespace router {
+ 
+RouteCache::RouteCache(size_t capacity) : capacity_(capacity) {}
+ 
+std::shared_ptr<const CachedRoute> RouteCache::Find(StopId from, StopId to) {
+    std::lock_guard guard(mutex_);
+    
+    const auto it = stops_to_entry_.find({from, to});
+    if (it == stops_to_entry_.end()) {
+        ++misses_;
+        return nullptr;
+    }
+    
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    
+    return it->second->second;
+}
+ 
+void RouteCache::Insert(StopId from, StopId to, CachedRoute route) {
+    std::lock_guard guard(mutex_);
+    
+    if (capacity_ == 0) {
+        return;
+    }
+    
+    auto cached_route = std::make_shared<const CachedRoute>(std::move(route));
+    const auto it = stops_to_entry_.find({from, to});
+    
+    if (it != stops_to_entry_.end()) {
+        it->second->second = std::move(cached_route);
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    
+    entries_.emplace_front(StopPair{from, to}, std::move(cached_route));
+    stops_to_entry_[{from, to}] = entries_.begin();
+    
+    Evict();
+}
+ 
+void RouteCache::SetCapacity(size_t capacity) {
+    std::lock_guard guard(mutex_);
+    
+    capacity_ = capacity;
+    Evict();
+}
+ 
+RouteCacheStats RouteCache::GetStats() const {
+    std::lock_guard guard(mutex_);
+    return {hits_, misses_, entries_.size(), capacity_};
+}
+ 
+void RouteCache::ResetStats() {
+    std::lock_guard guard(mutex_);
+    
+    hits_ = 0;
+    misses_ = 0;
+}
+ 
+void RouteCache::Evict() {
+ 
+    while (entries_.size() > capacity_) {
+        stops_to_entry_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+}
+ 
+} // namespace router
+} // namespace detail
+} // namespace transport_catalogue
@@ -0,0 +1,71 @@
+#pragma once
+ 
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+ 
+#include "domain.h"
+#include "json.h"
+ 
+namespace transport_catalogue {
+namespace detail {
+namespace router {
+ 
+using namespace domain;
+ 
+struct CachedRoute {
+    std::optional<RouteInfo> route_info;
+    json::Node items;
+};
+ 
+struct RouteCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t size = 0;
+    size_t capacity = 0;
+};
+ 
+// bounded LRU of finished routes keyed by (from, to) stop pair, safe to share between threads
+class RouteCache {
+public:
+    explicit RouteCache(size_t capacity = 0);
+    
+    std::shared_ptr<const CachedRoute> Find(StopId from, StopId to);
+    void Insert(StopId from, StopId to, CachedRoute route);
+    
+    void SetCapacity(size_t capacity);
+    
+    RouteCacheStats GetStats() const;
+    void ResetStats();
+ 
+private:
+    using StopPair = std::pair<StopId, StopId>;
+    
+    struct StopPairHasher {
+        size_t operator()(const StopPair& stops) const {
+            return std::hash<uint64_t>{}(static_cast<uint64_t>(stops.first) << 32 | stops.second);
+        }
+    };
+    
+    using Entry = std::pair<StopPair, std::shared_ptr<const CachedRoute>>;
+    
+    void Evict();
+    
+    mutable std::mutex mutex_;
+    
+    size_t capacity_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    
+    std::list<Entry> entries_;
+    std::unordered_map<StopPair, std::list<Entry>::iterator, StopPairHasher> stops_to_entry_;
+};
+ 
+} // namespace router
+} // namespace detail
+} // namespace transport_catalogue
@@ -4,52 +4,151 @@
  
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
  
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+ 
 namespace graph {
  
+namespace detail {
+ 
+class Barrier {
+public:
+    explicit Barrier(size_t threads_count) : threads_count_(threads_count) {}
+    
+    void Wait() {
+        std::unique_lock lock(mutex_);
+        const size_t generation = generation_;
+        
+        if (++waiting_ == threads_count_) {
+            waiting_ = 0;
+            ++generation_;
+            condition_.notify_all();
+        } else {
+            condition_.wait(lock, [this, generation] {return generation != generation_;});
+        }
+    }
+    
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    size_t threads_count_;
+    size_t waiting_ = 0;
+    size_t generation_ = 0;
+};
+ 
+} // namespace detail
+ 
 template <typename Weight>
 class Router {
 using Graph = DirectedWeightedGraph<Weight>;
  
 public:
-    explicit Router(const Graph& graph);
- 
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
     
-    void Build() {
-        InitializeRoutesInternalData(graph_);
+    // V x V table kept as two row-major planes, cell (from, to) is at from * V + to;
+    // no route is INFINITE_WEIGHT, no previous edge is NONE_EDGE
+    struct RoutesInternalData {
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+    };
+    
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::max();
+    static constexpr uint32_t NONE_EDGE = std::numeric_limits<uint32_t>::max();
+    
+    // threads_count == 0 means one worker per hardware thread
+    explicit Router(const Graph& graph, size_t threads_count = 0);
+    Router(const Graph& graph, RoutesInternalData routes_internal_data);
+    
+    void Build(size_t threads_count = 0) {
         const size_t vertex_count = graph_.GetVertexCount();
         
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        routes_internal_data_.weights.assign(vertex_count * vertex_count, INFINITE_WEIGHT);
+        routes_internal_data_.prev_edges.assign(vertex_count * vertex_count, NONE_EDGE);
+        InitializeRoutesInternalData(graph_);
+        
+        if (threads_count == 0) {
+            threads_count = std::thread::hardware_concurrency();
+        }
+        
+        threads_count = std::clamp<size_t>(threads_count, 1, std::max<size_t>(vertex_count / MIN_ROWS_PER_THREAD, 1));
+        
+        const size_t block_size = std::clamp<size_t>(PIVOT_ROWS_BYTES / (std::max<size_t>(vertex_count, 1) * CELL_BYTES), 
+                                                     MIN_PIVOT_BLOCK_SIZE, 
+                                                     MAX_PIVOT_BLOCK_SIZE);
+        
+        RoutesInternalData pivot_rows{std::vector<Weight>(block_size * vertex_count), 
+                                      std::vector<uint32_t>(block_size * vertex_count)};
+        detail::Barrier barrier(threads_count);
+        
+        auto relax_rows = [this, vertex_count, threads_count, block_size, &pivot_rows, &barrier](size_t thread) {
+            const VertexId rows_begin = vertex_count * thread / threads_count;
+            const VertexId rows_end = vertex_count * (thread + 1) / threads_count;
+            
+            for (VertexId block_begin = 0; block_begin < vertex_count; block_begin += block_size) {
+                const VertexId block_end = std::min(vertex_count, block_begin + block_size);
+                
+                if (thread == 0) {
+                    RelaxPivotBlock(vertex_count, block_begin, block_end, pivot_rows);
+                }
+                
+                barrier.Wait();
+                RelaxRowsThroughPivotBlock(vertex_count, block_begin, block_end, pivot_rows, rows_begin, rows_end);
+                barrier.Wait();
+            }
+        };
+        
+        std::vector<std::thread> workers;
+        workers.reserve(threads_count - 1);
+        
+        for (size_t thread = 1; thread < threads_count; ++thread) {
+            workers.emplace_back(relax_rows, thread);
+        }
+        
+        relax_rows(0);
+        
+        for (auto& worker : workers) {
+            worker.join();
         }
     }
     
     std::optional<RouteInfo> Build_route(VertexId from, VertexId to) const;
- 
-private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
     
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    const RoutesInternalData& GetRoutesInternalData() const {
+        return routes_internal_data_;
+    }
  
+private:
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
         
+        if (graph.GetEdgeCount() >= NONE_EDGE) {
+            throw std::length_error("Too many edges for the routes table");
+        }
+        
+        auto& weights = routes_internal_data_.weights;
+        auto& prev_edges = routes_internal_data_.prev_edges;
+        
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            weights[vertex * vertex_count + vertex] = ZERO_WEIGHT;
             
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
@@ -58,80 +157,171 @@ private:
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
                 
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t cell = vertex * vertex_count + edge.to;
+                if (weights[cell] > edge.weight) {
+                    weights[cell] = edge.weight;
+                    prev_edges[cell] = static_cast<uint32_t>(edge_id);
                 }
             }
         }
     }
- 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, 
-                     const RouteInternalData& route_from,
-                     const RouteInternalData& route_to) {
-                     
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    
+    // Pivots are processed in blocks. The rows of the block are relaxed first, in pivot order, and
+    // each pivot row is copied aside exactly as it is when its pivot comes up. Every other row then
+    // runs through the whole block against these copies while it stays in cache. Each cell sees the
+    // same operands in the same order as in the plain triple loop, so the table (including the choice
+    // between equal-weight routes) is identical to the single-threaded Floyd-Warshall result.
+    void RelaxPivotBlock(size_t vertex_count, VertexId block_begin, VertexId block_end, 
+                         RoutesInternalData& pivot_rows) {
+        auto& weights = routes_internal_data_.weights;
+        auto& prev_edges = routes_internal_data_.prev_edges;
+        
+        for (VertexId vertex_through = block_begin; vertex_through < block_end; ++vertex_through) {
+            const size_t pivot_row = (vertex_through - block_begin) * vertex_count;
+            
+            std::copy_n(&weights[vertex_through * vertex_count], vertex_count, &pivot_rows.weights[pivot_row]);
+            std::copy_n(&prev_edges[vertex_through * vertex_count], vertex_count, &pivot_rows.prev_edges[pivot_row]);
+            
+            for (VertexId vertex_from = block_begin; vertex_from < block_end; ++vertex_from) {
+                const size_t row = vertex_from * vertex_count;
+                
+                if (weights[row + vertex_through] != INFINITE_WEIGHT && vertex_from != vertex_through) {
+                    RelaxRow(&weights[row], &prev_edges[row], 
+                             &pivot_rows.weights[pivot_row], &pivot_rows.prev_edges[pivot_row], 
+                             weights[row + vertex_through], prev_edges[row + vertex_through], 
+                             vertex_count);
+                }
+            }
+        }
+    }
+    
+    void RelaxRowsThroughPivotBlock(size_t vertex_count, VertexId block_begin, VertexId block_end, 
+                                    const RoutesInternalData& pivot_rows, 
+                                    VertexId rows_begin, VertexId rows_end) {
+        auto& weights = routes_internal_data_.weights;
+        auto& prev_edges = routes_internal_data_.prev_edges;
+        
+        for (VertexId vertex_from = rows_begin; vertex_from < rows_end; ++vertex_from) {
+            
+            if (vertex_from >= block_begin && vertex_from < block_end) {
+                continue;
+            }
+            
+            const size_t row = vertex_from * vertex_count;
+            
+            for (VertexId vertex_through = block_begin; vertex_through < block_end; ++vertex_through) {
+                const size_t pivot_row = (vertex_through - block_begin) * vertex_count;
+                
+                if (weights[row + vertex_through] != INFINITE_WEIGHT) {
+                    RelaxRow(&weights[row], &prev_edges[row], 
+                             &pivot_rows.weights[pivot_row], &pivot_rows.prev_edges[pivot_row], 
+                             weights[row + vertex_through], prev_edges[row + vertex_through], 
+                             vertex_count);
+                }
+            }
         }
     }
- 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
     
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+    // min-plus step over one row: weights_from[j] = min(weights_from[j], weight_from + weights_through[j]);
+    // a missing route through the pivot is INFINITE_WEIGHT and never wins the comparison
+    static void RelaxRow(Weight* weights_from, uint32_t* prev_edges_from, 
+                         const Weight* weights_through, const uint32_t* prev_edges_through, 
+                         const Weight weight_from, const uint32_t prev_edge_from, size_t vertex_count) {
+        VertexId vertex_to = 0;
         
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
+        auto relax_route = [&](VertexId vertex) {
+            weights_from[vertex] = weight_from + weights_through[vertex];
+            prev_edges_from[vertex] = prev_edges_through[vertex] != NONE_EDGE ? prev_edges_through[vertex] : prev_edge_from;
+        };
+        
+#if defined(__AVX__)
+        if constexpr (std::is_same_v<Weight, double>) {
+            const __m256d weights_from_pivot = _mm256_set1_pd(weight_from);
+            
+            for (; vertex_to + 4 <= vertex_count; vertex_to += 4) {
+                const __m256d candidate_weights = _mm256_add_pd(weights_from_pivot, _mm256_loadu_pd(weights_through + vertex_to));
+                int mask = _mm256_movemask_pd(_mm256_cmp_pd(candidate_weights, _mm256_loadu_pd(weights_from + vertex_to), _CMP_LT_OQ));
+                
+                for (; mask != 0; mask &= mask - 1) {
+                    relax_route(vertex_to + __builtin_ctz(mask));
+                }
+            }
+        }
+#elif defined(__SSE2__)
+        if constexpr (std::is_same_v<Weight, double>) {
+            const __m128d weights_from_pivot = _mm_set1_pd(weight_from);
             
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+            for (; vertex_to + 2 <= vertex_count; vertex_to += 2) {
+                const __m128d candidate_weights = _mm_add_pd(weights_from_pivot, _mm_loadu_pd(weights_through + vertex_to));
+                const int mask = _mm_movemask_pd(_mm_cmplt_pd(candidate_weights, _mm_loadu_pd(weights_from + vertex_to)));
                 
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+                if (mask & 1) {
+                    relax_route(vertex_to);
+                }
+                if (mask & 2) {
+                    relax_route(vertex_to + 1);
                 }
             }
         }
+#endif
+        
+        for (; vertex_to < vertex_count; ++vertex_to) {
+            if (weights_through[vertex_to] != INFINITE_WEIGHT 
+                && weight_from + weights_through[vertex_to] < weights_from[vertex_to]) {
+                relax_route(vertex_to);
+            }
+        }
     }
     
+    static constexpr size_t MIN_ROWS_PER_THREAD = 64;
+    static constexpr size_t MIN_PIVOT_BLOCK_SIZE = 8;
+    static constexpr size_t MAX_PIVOT_BLOCK_SIZE = 64;
+    static constexpr size_t PIVOT_ROWS_BYTES = 1 << 20;
+    static constexpr size_t CELL_BYTES = sizeof(Weight) + sizeof(uint32_t);
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
 };
  
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph) : graph_(graph)
-                                           , routes_internal_data_(graph.GetVertexCount()
-                                           , std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount())) {
-    InitializeRoutesInternalData(graph);
+Router<Weight>::Router(const Graph& graph, size_t threads_count) : graph_(graph) {
+    Build(threads_count);
+}
  
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, RoutesInternalData routes_internal_data) : graph_(graph)
+                                                                                  , routes_internal_data_(std::move(routes_internal_data)) {
+    
+    if (routes_internal_data_.weights.size() != graph.GetVertexCount() * graph.GetVertexCount()
+        || routes_internal_data_.prev_edges.size() != routes_internal_data_.weights.size()) {
+        throw std::invalid_argument("Routes table does not match the graph");
     }
 }
  
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::Build_route(VertexId from,
                                                                               VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    
+    const size_t row = from * graph_.GetVertexCount();
+    const Weight weight = routes_internal_data_.weights[row + to];
     
-    if (!route_internal_data) {
+    if (weight == INFINITE_WEIGHT) {
         return std::nullopt;
     }
     
-    const Weight weight = route_internal_data->weight;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
+    for (uint32_t edge_id = routes_internal_data_.prev_edges[row + to];
+         edge_id != NONE_EDGE;
+         edge_id = routes_internal_data_.prev_edges[row + graph_.GetEdge(edge_id).from]) {
         
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     
     std::reverse(edges.begin(), edges.end());
- 
+    
     return RouteInfo{weight, std::move(edges)};
 }
  
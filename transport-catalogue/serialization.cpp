@@ -1,77 +1,264 @@
 #include "serialization.h"
+#include "flat_serialization.h"
+ 
+#include <cmath>
+#include <fstream>
+#include <tuple>
  
 namespace serialization {
     
-template <typename It>
-uint32_t calculate_id(It start, It end, std::string_view name) {
- 
-    auto stop_it = std::find_if(start, end, [&name](const domain::Stop stop) {return stop.name == name;});
-    return std::distance(start, stop_it);
+namespace {
+    
+// units of 1e-7 degree, about a centimetre
+constexpr double COORDINATE_SCALE = 1e7;
+    
+// fixed-point coordinates, or nothing when some coordinate would not come back exactly
+std::optional<std::vector<std::pair<int64_t, int64_t>>> QuantizeCoordinates(const transport_catalogue::TransportCatalogue& transport_catalogue) {
+    
+    std::vector<std::pair<int64_t, int64_t>> fixed_coordinates;
+    fixed_coordinates.reserve(transport_catalogue.GetStopsCount());
+    
+    for (const geo::Coordinates& coordinates : transport_catalogue.GetStopsCoordinates()) {
+        const int64_t latitude = std::llround(coordinates.latitude * COORDINATE_SCALE);
+        const int64_t longitude = std::llround(coordinates.longitude * COORDINATE_SCALE);
+        
+        if (static_cast<double>(latitude) / COORDINATE_SCALE != coordinates.latitude 
+            || static_cast<double>(longitude) / COORDINATE_SCALE != coordinates.longitude) {
+            return std::nullopt;
+        }
+        
+        fixed_coordinates.push_back({latitude, longitude});
+    }
+    
+    return fixed_coordinates;
 }
- 
-transport_catalogue_protobuf::TransportCatalogue SerializationTransportCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue) {
+    
+} // namespace
+    
+transport_catalogue_protobuf::TransportCatalogue SerializationTransportCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue, bool compact) {
     
     transport_catalogue_protobuf::TransportCatalogue transport_catalogue_proto;
  
-    const auto& stops = transport_catalogue.get_stops();
-    const auto& buses = transport_catalogue.get_buses();
-    const auto& distances = transport_catalogue.get_distance();
+    const auto distances = transport_catalogue.GetDistance();
+    const auto fixed_coordinates = compact ? QuantizeCoordinates(transport_catalogue) : std::nullopt;
     
-    int id = 0;
-    for (const auto& stop : stops) {
+    for (domain::StopId stop = 0; stop < transport_catalogue.GetStopsCount(); ++stop) {
  
         transport_catalogue_protobuf::Stop stop_proto;
+        const auto& coordinates = transport_catalogue.GetStopCoordinates(stop);
  
-        stop_proto.set_id(id);
-        stop_proto.set_name(stop.name);
-        stop_proto.set_latitude(stop.latitude);
-        stop_proto.set_longitude(stop.longitude);
+        stop_proto.set_id(stop);
+        stop_proto.set_name(std::string(transport_catalogue.GetStopName(stop)));
+        
+        if (!fixed_coordinates) {
+            stop_proto.set_latitude(coordinates.latitude);
+            stop_proto.set_longitude(coordinates.longitude);
+        }
         
         *transport_catalogue_proto.add_stops() = std::move(stop_proto);
+    }
+    
+    if (fixed_coordinates) {
+        auto& compact_coordinates_proto = *transport_catalogue_proto.mutable_compact_coordinates();
+        std::pair<int64_t, int64_t> previous = {0, 0};
         
-        ++id;
+        for (const auto& [latitude, longitude] : *fixed_coordinates) {
+            compact_coordinates_proto.add_latitude_deltas(latitude - previous.first);
+            compact_coordinates_proto.add_longitude_deltas(longitude - previous.second);
+            previous = {latitude, longitude};
+        }
     }
  
-    for (const auto& bus : buses) {
+    for (domain::BusId bus = 0; bus < transport_catalogue.GetBusesCount(); ++bus) {
  
         transport_catalogue_protobuf::Bus bus_proto;
  
-        bus_proto.set_name(bus.name);
+        bus_proto.set_name(std::string(transport_catalogue.GetBusName(bus)));
  
-        for (auto stop : bus.stops) {
-            uint32_t stop_id = calculate_id(stops.cbegin(), 
-                                            stops.cend(), 
-                                            stop->name);
-            bus_proto.add_stops(stop_id);
+        // a compact bus leaves its road distances to be summed up again from the distance table
+        if (compact) {
+            domain::StopId previous = 0;
+            
+            for (domain::StopId stop : transport_catalogue.GetBusStops(bus)) {
+                bus_proto.add_stop_deltas(static_cast<int32_t>(stop - previous));
+                previous = stop;
+            }
+            
+        } else {
+            
+            for (domain::StopId stop : transport_catalogue.GetBusStops(bus)) {
+                bus_proto.add_stops(stop);
+            }
+        
+            for (size_t distance : transport_catalogue.GetBusDistances(bus)) {
+                bus_proto.add_distances(distance);
+            }
         }
  
-        bus_proto.set_is_roundtrip(bus.is_roundtrip);
-        bus_proto.set_route_length(bus.route_length);
+        bus_proto.set_is_roundtrip(transport_catalogue.IsRoundtrip(bus));
+        
+        const auto& bus_stats = transport_catalogue.GetBusStats(bus);
+        auto& bus_stats_proto = *bus_proto.mutable_stats();
+        
+        bus_stats_proto.set_stops_on_route(bus_stats.stops_on_route);
+        bus_stats_proto.set_unique_stops(bus_stats.unique_stops);
+        bus_stats_proto.set_route_length(bus_stats.route_length);
+        bus_stats_proto.set_geo_length(bus_stats.geo_length);
+        bus_stats_proto.set_curvature(bus_stats.curvature);
  
         *transport_catalogue_proto.add_buses() = std::move(bus_proto);
     }
     
-    for (const auto& [pair_stops, pair_distance] : distances) {
+    const auto& stop_bus_offsets = transport_catalogue.GetStopBusOffsets();
+    const auto& stop_bus_ids = transport_catalogue.GetStopBusIds();
+    
+    transport_catalogue_proto.mutable_stop_buses()->mutable_offsets()->Add(stop_bus_offsets.begin(), stop_bus_offsets.end());
+    transport_catalogue_proto.mutable_stop_buses()->mutable_bus_ids()->Add(stop_bus_ids.begin(), stop_bus_ids.end());
+    
+    const auto& stops_by_name = transport_catalogue.GetStopsByName();
+    const auto& buses_by_name = transport_catalogue.GetBusesByName();
+    
+    transport_catalogue_proto.mutable_name_order()->mutable_stops()->Add(stops_by_name.begin(), stops_by_name.end());
+    transport_catalogue_proto.mutable_name_order()->mutable_buses()->Add(buses_by_name.begin(), buses_by_name.end());
+    
+    const auto& stop_grid = transport_catalogue.GetStopGrid();
+    const auto& stop_grid_layout = stop_grid.GetLayout();
+    auto& stop_grid_proto = *transport_catalogue_proto.mutable_stop_grid();
+    
+    stop_grid_proto.set_min_latitude(stop_grid_layout.min.latitude);
+    stop_grid_proto.set_min_longitude(stop_grid_layout.min.longitude);
+    stop_grid_proto.set_cell_height(stop_grid_layout.cell_height);
+    stop_grid_proto.set_cell_width(stop_grid_layout.cell_width);
+    stop_grid_proto.set_rows(stop_grid_layout.rows);
+    stop_grid_proto.set_cols(stop_grid_layout.cols);
+    stop_grid_proto.mutable_cell_offsets()->Add(stop_grid.GetCellOffsets().begin(), stop_grid.GetCellOffsets().end());
+    stop_grid_proto.mutable_stop_ids()->Add(stop_grid.GetStopIds().begin(), stop_grid.GetStopIds().end());
+    
+    if (compact) {
+        std::vector<domain::Distance> sorted_distances(distances.begin(), distances.end());
+        
+        std::sort(sorted_distances.begin(), sorted_distances.end(), [](const domain::Distance& lhs, const domain::Distance& rhs) {
+            return std::tie(lhs.start, lhs.end) < std::tie(rhs.start, rhs.end);
+        });
+        
+        auto& compact_distances_proto = *transport_catalogue_proto.mutable_compact_distances();
+        domain::StopId previous_start = 0;
+        domain::StopId previous_end = 0;
+        
+        for (const domain::Distance& distance : sorted_distances) {
+        
+            if (distance.start != previous_start) {
+                previous_end = 0;
+            }
+            
+            compact_distances_proto.add_start_deltas(distance.start - previous_start);
+            compact_distances_proto.add_end_deltas(static_cast<int32_t>(distance.end - previous_end));
+            compact_distances_proto.add_distances(distance.distance);
+            
+            previous_start = distance.start;
+            previous_end = distance.end;
+        }
+        
+    } else {
+        
+        for (const domain::Distance distance : distances) {
  
-        transport_catalogue_protobuf::Distance distance_proto;
+            transport_catalogue_protobuf::Distance distance_proto;
  
-        distance_proto.set_start(calculate_id(stops.cbegin(), 
-                                              stops.cend(), 
-                                              pair_stops.first->name));
-                                              
-        distance_proto.set_end(calculate_id(stops.cbegin(), 
-                                            stops.cend(), 
-                                            pair_stops.second->name));
-                                            
-        distance_proto.set_distance(pair_distance);
+            distance_proto.set_start(distance.start);
+            distance_proto.set_end(distance.end);
+            distance_proto.set_distance(distance.distance);
  
-        *transport_catalogue_proto.add_distances() = std::move(distance_proto);
+            *transport_catalogue_proto.add_distances() = std::move(distance_proto);
+        }
     }
  
     return transport_catalogue_proto;
 }
  
     
+void CheckNameOrder(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                    const transport_catalogue::Table<domain::StopId>& stops_by_name,
+                    const transport_catalogue::Table<domain::BusId>& buses_by_name) {
+    
+    const auto stops_count = transport_catalogue.GetStopsCount();
+    const auto buses_count = transport_catalogue.GetBusesCount();
+    
+    if (stops_by_name.size() != stops_count || buses_by_name.size() != buses_count) {
+        throw std::runtime_error("corrupted name order in serialized file");
+    }
+    
+    // a permutation of the ids whose names do not decrease
+    std::vector<bool> stop_seen(stops_count, false);
+    std::vector<bool> bus_seen(buses_count, false);
+    
+    for (size_t i = 0; i < stops_by_name.size(); ++i) {
+        
+        if (stops_by_name[i] >= stops_count || stop_seen[stops_by_name[i]] 
+            || (i > 0 && transport_catalogue.GetStopName(stops_by_name[i]) < transport_catalogue.GetStopName(stops_by_name[i - 1]))) {
+            throw std::runtime_error("corrupted name order in serialized file");
+        }
+        
+        stop_seen[stops_by_name[i]] = true;
+    }
+    
+    for (size_t i = 0; i < buses_by_name.size(); ++i) {
+        
+        if (buses_by_name[i] >= buses_count || bus_seen[buses_by_name[i]] 
+            || (i > 0 && transport_catalogue.GetBusName(buses_by_name[i]) < transport_catalogue.GetBusName(buses_by_name[i - 1]))) {
+            throw std::runtime_error("corrupted name order in serialized file");
+        }
+        
+        bus_seen[buses_by_name[i]] = true;
+    }
+}
+    
+void CheckStopBuses(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                    const transport_catalogue::Table<uint32_t>& offsets,
+                    const transport_catalogue::Table<domain::BusId>& bus_ids) {
+    
+    const auto stops_count = transport_catalogue.GetStopsCount();
+    
+    if (offsets.size() != stops_count + 1 
+        || offsets[stops_count] != bus_ids.size()
+        || !std::is_sorted(offsets.begin(), offsets.end())) {
+        throw std::runtime_error("corrupted stop buses in serialized file");
+    }
+    
+    for (const auto bus_id : bus_ids) {
+        
+        if (bus_id >= transport_catalogue.GetBusesCount()) {
+            throw std::runtime_error("corrupted stop buses in serialized file");
+        }
+    }
+}
+    
+void CheckStopGrid(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                   const transport_catalogue::StopGrid::Layout& layout,
+                   const transport_catalogue::Table<uint32_t>& cell_offsets,
+                   const transport_catalogue::Table<domain::StopId>& stop_ids) {
+    
+    const auto stops_count = transport_catalogue.GetStopsCount();
+    const size_t cells_count = static_cast<size_t>(layout.rows) * layout.cols;
+    
+    if (layout.rows == 0 || layout.cols == 0
+        || !(layout.cell_height > 0.) || !(layout.cell_width > 0.)
+        || cell_offsets.size() != cells_count + 1
+        || stop_ids.size() != stops_count
+        || cell_offsets[0] != 0
+        || cell_offsets[cells_count] != stops_count
+        || !std::is_sorted(cell_offsets.begin(), cell_offsets.end())) {
+        throw std::runtime_error("corrupted stop grid in serialized file");
+    }
+    
+    for (const auto stop_id : stop_ids) {
+        
+        if (stop_id >= stops_count) {
+            throw std::runtime_error("corrupted stop grid in serialized file");
+        }
+    }
+}
+    
 transport_catalogue::TransportCatalogue DeserializationTransportCatalogue(const transport_catalogue_protobuf::TransportCatalogue& transport_catalogue_proto) {
  
     transport_catalogue::TransportCatalogue transport_catalogue;
@@ -80,33 +267,81 @@ transport_catalogue::TransportCatalogue DeserializationTransportCatalogue(const
     const auto& buses_proto = transport_catalogue_proto.buses();
     const auto& distances_proto = transport_catalogue_proto.distances();
     
-    for (const auto& stop : stops_proto) {
+    const bool has_compact_coordinates = transport_catalogue_proto.has_compact_coordinates();
+    const auto& compact_coordinates_proto = transport_catalogue_proto.compact_coordinates();
         
+    if (has_compact_coordinates 
+        && (compact_coordinates_proto.latitude_deltas_size() != stops_proto.size() 
+            || compact_coordinates_proto.longitude_deltas_size() != stops_proto.size())) {
+        throw std::runtime_error("corrupted coordinates in serialized file");
+    }
+    
+    int64_t latitude = 0;
+    int64_t longitude = 0;
+    
+    for (int i = 0; i < stops_proto.size(); ++i) {
+        
+        const auto& stop = stops_proto[i];
         domain::Stop tc_stop;
         
         tc_stop.name = stop.name();
-        tc_stop.latitude = stop.latitude();
-        tc_stop.longitude = stop.longitude();
         
-        transport_catalogue.add_stop(std::move(tc_stop));
+        if (has_compact_coordinates) {
+            latitude += compact_coordinates_proto.latitude_deltas(i);
+            longitude += compact_coordinates_proto.longitude_deltas(i);
+            
+            tc_stop.latitude = static_cast<double>(latitude) / COORDINATE_SCALE;
+            tc_stop.longitude = static_cast<double>(longitude) / COORDINATE_SCALE;
+            
+        } else {
+            tc_stop.latitude = stop.latitude();
+            tc_stop.longitude = stop.longitude();
+        }
+        
+        transport_catalogue.AddStop(std::move(tc_stop));
     }
     
-    const auto& tc_stops = transport_catalogue.get_stops(); 
+    const auto stops_count = transport_catalogue.GetStopsCount();
     
     std::vector<domain::Distance> distances;
     for (const auto& distance : distances_proto) {
         
-        domain::Distance tc_distance;
+        if (distance.start() >= stops_count || distance.end() >= stops_count) {
+            throw std::runtime_error("corrupted distances in serialized file");
+        }
+        
+        distances.push_back({distance.start(), distance.end(), static_cast<int>(distance.distance())});
+    }
+    
+    const auto& compact_distances_proto = transport_catalogue_proto.compact_distances();
+    
+    if (compact_distances_proto.start_deltas_size() != compact_distances_proto.end_deltas_size() 
+        || compact_distances_proto.start_deltas_size() != compact_distances_proto.distances_size()) {
+        throw std::runtime_error("corrupted distances in serialized file");
+    }
+    
+    uint64_t start = 0;
+    int64_t end = 0;
+    
+    for (int i = 0; i < compact_distances_proto.distances_size(); ++i) {
+    
+        if (compact_distances_proto.start_deltas(i) != 0) {
+            end = 0;
+        }
         
-        tc_distance.start = transport_catalogue.get_stop(tc_stops[distance.start()].name);
-        tc_distance.end = transport_catalogue.get_stop(tc_stops[distance.end()].name);
+        start += compact_distances_proto.start_deltas(i);
+        end += compact_distances_proto.end_deltas(i);
         
-        tc_distance.distance = distance.distance();
+        if (start >= stops_count || end < 0 || static_cast<uint64_t>(end) >= stops_count) {
+            throw std::runtime_error("corrupted distances in serialized file");
+        }
         
-        distances.push_back(tc_distance);
+        distances.push_back({static_cast<domain::StopId>(start), 
+                             static_cast<domain::StopId>(end), 
+                             static_cast<int>(compact_distances_proto.distances(i))});
     }
     
-    transport_catalogue.add_distance(distances);       
+    transport_catalogue.AddDistance(distances);       
     
     for (const auto& bus_proto : buses_proto) {  
     
@@ -115,16 +350,96 @@ transport_catalogue::TransportCatalogue DeserializationTransportCatalogue(const
         tc_bus.name = bus_proto.name();
  
         for (auto stop_id : bus_proto.stops()) {
-            auto name = tc_stops[stop_id].name;            
-            tc_bus.stops.push_back(transport_catalogue.get_stop(name));
+            
+            if (stop_id >= stops_count) {
+                throw std::runtime_error("corrupted bus stops in serialized file");
+            }
+            
+            tc_bus.stops.push_back(stop_id);
+        }
+        
+        int64_t stop_id = 0;
+        
+        for (auto stop_delta : bus_proto.stop_deltas()) {
+            stop_id += stop_delta;
+            
+            if (stop_id < 0 || static_cast<uint64_t>(stop_id) >= stops_count) {
+                throw std::runtime_error("corrupted bus stops in serialized file");
+            }
+            
+            tc_bus.stops.push_back(static_cast<domain::StopId>(stop_id));
+        }
+        
+        if (bus_proto.distances_size() != 0 && static_cast<size_t>(bus_proto.distances_size()) != tc_bus.stops.size()) {
+            throw std::runtime_error("corrupted bus distances in serialized file");
         }
+        
+        tc_bus.distances.assign(bus_proto.distances().begin(), bus_proto.distances().end());
  
         tc_bus.is_roundtrip = bus_proto.is_roundtrip();
-        tc_bus.route_length = bus_proto.route_length();
         
-        transport_catalogue.add_bus(std::move(tc_bus));
+        if (bus_proto.has_stats()) {
+            const auto& bus_stats_proto = bus_proto.stats();
+            
+            tc_bus.stats = domain::BusStats{bus_stats_proto.stops_on_route(), 
+                                            bus_stats_proto.unique_stops(), 
+                                            bus_stats_proto.route_length(), 
+                                            bus_stats_proto.geo_length(), 
+                                            bus_stats_proto.curvature()};
+        }
+        
+        transport_catalogue.AddBus(std::move(tc_bus));
     }   
     
+    const auto& name_order_proto = transport_catalogue_proto.name_order();
+    
+    if (name_order_proto.stops_size() == 0 && name_order_proto.buses_size() == 0) {
+        transport_catalogue.BuildNameOrder();
+        
+    } else {
+        transport_catalogue::Table<domain::StopId> stops_by_name = std::vector<domain::StopId>(name_order_proto.stops().begin(), name_order_proto.stops().end());
+        transport_catalogue::Table<domain::BusId> buses_by_name = std::vector<domain::BusId>(name_order_proto.buses().begin(), name_order_proto.buses().end());
+        
+        CheckNameOrder(transport_catalogue, stops_by_name, buses_by_name);
+        transport_catalogue.SetNameOrder(std::move(stops_by_name), std::move(buses_by_name));
+    }
+    
+    const auto& stop_buses_proto = transport_catalogue_proto.stop_buses();
+    
+    if (stop_buses_proto.offsets_size() == 0) {
+        transport_catalogue.BuildStopBuses();
+        
+    } else {
+        transport_catalogue::Table<uint32_t> offsets = std::vector<uint32_t>(stop_buses_proto.offsets().begin(), stop_buses_proto.offsets().end());
+        transport_catalogue::Table<domain::BusId> bus_ids = std::vector<domain::BusId>(stop_buses_proto.bus_ids().begin(), stop_buses_proto.bus_ids().end());
+        
+        CheckStopBuses(transport_catalogue, offsets, bus_ids);
+        transport_catalogue.SetStopBuses(std::move(offsets), std::move(bus_ids));
+    }
+    
+    const auto& stop_grid_proto = transport_catalogue_proto.stop_grid();
+    
+    if (stop_grid_proto.rows() == 0 || stop_grid_proto.cols() == 0) {
+        transport_catalogue.BuildStopGrid();
+        
+    } else {
+        transport_catalogue::StopGrid::Layout stop_grid_layout;
+        
+        stop_grid_layout.min = {stop_grid_proto.min_latitude(), stop_grid_proto.min_longitude()};
+        stop_grid_layout.cell_height = stop_grid_proto.cell_height();
+        stop_grid_layout.cell_width = stop_grid_proto.cell_width();
+        stop_grid_layout.rows = stop_grid_proto.rows();
+        stop_grid_layout.cols = stop_grid_proto.cols();
+        
+        transport_catalogue::Table<uint32_t> cell_offsets = std::vector<uint32_t>(stop_grid_proto.cell_offsets().begin(), stop_grid_proto.cell_offsets().end());
+        transport_catalogue::Table<domain::StopId> stop_ids = std::vector<domain::StopId>(stop_grid_proto.stop_ids().begin(), stop_grid_proto.stop_ids().end());
+        
+        CheckStopGrid(transport_catalogue, stop_grid_layout, cell_offsets, stop_ids);
+        transport_catalogue.SetStopGrid(stop_grid_layout, std::move(cell_offsets), std::move(stop_ids));
+    }
+    
+    transport_catalogue.BuildNameIndex();
+    
     return transport_catalogue;
 }
     
@@ -255,6 +570,7 @@ transport_catalogue_protobuf::RoutingSettings SerializationRoutingSettings(const
     
     routing_settings_proto.set_bus_wait_time(routing_settings.bus_wait_time);
     routing_settings_proto.set_bus_velocity(routing_settings.bus_velocity);
+    routing_settings_proto.set_router_engine(static_cast<transport_catalogue_protobuf::RouterEngine>(routing_settings.router_engine));
  
     return routing_settings_proto;
 }
@@ -265,24 +581,264 @@ domain::RoutingSettings DeserializationRoutingSettings(const transport_catalogue
     
     routing_settings.bus_wait_time = routing_settings_proto.bus_wait_time();
     routing_settings.bus_velocity = routing_settings_proto.bus_velocity();
+    routing_settings.router_engine = static_cast<domain::RouterEngine>(routing_settings_proto.router_engine());
     
     return routing_settings;
 }
     
+graph_serialize::Graph SerializationGraph(const graph::DirectedWeightedGraph<double>& graph) {
+    
+    graph_serialize::Graph graph_proto;
+    
+    for (size_t edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        
+        const auto& edge = graph.GetEdge(edge_id);
+        graph_serialize::Edge edge_proto;
+        
+        edge_proto.set_from(edge.from);
+        edge_proto.set_to(edge.to);
+        edge_proto.set_weight(edge.weight);
+        
+        *graph_proto.add_edges() = std::move(edge_proto);
+    }
+    
+    graph_proto.set_vertex_count(graph.GetVertexCount());
+    
+    return graph_proto;
+}
+    
+graph::DirectedWeightedGraph<double> DeserializationGraph(const graph_serialize::Graph& graph_proto) {
+    
+    graph::DirectedWeightedGraph<double> graph(graph_proto.vertex_count());
+    
+    for (const auto& edge_proto : graph_proto.edges()) {
+        
+        if (edge_proto.from() >= graph.GetVertexCount() || edge_proto.to() >= graph.GetVertexCount()) {
+            throw std::runtime_error("corrupted graph in serialized file");
+        }
+        
+        graph.AddEdge({edge_proto.from(), edge_proto.to(), edge_proto.weight()});
+    }
+    
+    // the stored graph was frozen, so its edges already come in incidence order
+    const auto new_edge_ids = graph.Freeze();
+    
+    for (size_t edge_id = 0; edge_id < new_edge_ids.size(); ++edge_id) {
+        
+        if (new_edge_ids[edge_id] != edge_id) {
+            throw std::runtime_error("graph edges in serialized file are not in incidence order");
+        }
+    }
+    
+    return graph;
+}
+    
+graph_serialize::Router SerializationRouter(const graph::Router<double>& router) {
+    
+    graph_serialize::Router router_proto;
+    
+    const auto& routes_internal_data = router.GetRoutesInternalData();
+    
+    router_proto.mutable_weights()->Add(routes_internal_data.weights.begin(), routes_internal_data.weights.end());
+    router_proto.mutable_prev_edges()->Add(routes_internal_data.prev_edges.begin(), routes_internal_data.prev_edges.end());
+    
+    return router_proto;
+}
+    
+graph::Router<double>::RoutesInternalData DeserializationRouter(const graph_serialize::Router& router_proto) {
+    
+    if (router_proto.weights_size() != router_proto.prev_edges_size()) {
+        throw std::runtime_error("corrupted router tables in serialized file");
+    }
+    
+    return {{router_proto.weights().begin(), router_proto.weights().end()}, 
+            {router_proto.prev_edges().begin(), router_proto.prev_edges().end()}};
+}
+    
+graph_serialize::ContractionHierarchy SerializationContractionHierarchy(const graph::ContractionHierarchyRouter<double>& router) {
+    
+    graph_serialize::ContractionHierarchy contraction_hierarchy_proto;
+    
+    const auto& hierarchy_internal_data = router.GetHierarchyInternalData();
+    
+    contraction_hierarchy_proto.mutable_ranks()->Add(hierarchy_internal_data.ranks.begin(), 
+                                                     hierarchy_internal_data.ranks.end());
+    contraction_hierarchy_proto.mutable_shortcut_first_edges()->Add(hierarchy_internal_data.shortcut_first_edges.begin(), 
+                                                                    hierarchy_internal_data.shortcut_first_edges.end());
+    contraction_hierarchy_proto.mutable_shortcut_second_edges()->Add(hierarchy_internal_data.shortcut_second_edges.begin(), 
+                                                                     hierarchy_internal_data.shortcut_second_edges.end());
+    
+    return contraction_hierarchy_proto;
+}
+    
+graph::ContractionHierarchyRouter<double>::HierarchyInternalData DeserializationContractionHierarchy(const graph_serialize::ContractionHierarchy& contraction_hierarchy_proto) {
+    
+    return {{contraction_hierarchy_proto.ranks().begin(), contraction_hierarchy_proto.ranks().end()}, 
+            {contraction_hierarchy_proto.shortcut_first_edges().begin(), contraction_hierarchy_proto.shortcut_first_edges().end()}, 
+            {contraction_hierarchy_proto.shortcut_second_edges().begin(), contraction_hierarchy_proto.shortcut_second_edges().end()}};
+}
+    
+transport_catalogue_protobuf::TransportRouter SerializationTransportRouter(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                                                                           const transport_catalogue::detail::router::TransportRouter& transport_router) {
+    
+    transport_catalogue_protobuf::TransportRouter transport_router_proto;
+    
+    *transport_router_proto.mutable_graph() = SerializationGraph(transport_router.GetGraph());
+    
+    if (transport_router.GetRoutingSettings().router_engine == domain::RouterEngine::ALL_PAIRS) {
+        *transport_router_proto.mutable_router() = SerializationRouter(transport_router.GetRouter());
+    }
+    
+    if (transport_router.GetRoutingSettings().router_engine == domain::RouterEngine::CONTRACTION_HIERARCHIES) {
+        *transport_router_proto.mutable_contraction_hierarchy() = SerializationContractionHierarchy(transport_router.GetContractionHierarchyRouter());
+    }
+    
+    const auto& stop_to_router = transport_router.GetStopToVertex();
+    
+    for (domain::StopId stop = 0; stop < stop_to_router.size(); ++stop) {
+        
+        transport_catalogue_protobuf::RouterByStop router_by_stop_proto;
+        const auto& router_by_stop = stop_to_router[stop];
+        
+        router_by_stop_proto.set_stop_id(stop);
+        router_by_stop_proto.set_bus_wait_start(router_by_stop.bus_wait_start);
+        router_by_stop_proto.set_bus_wait_end(router_by_stop.bus_wait_end);
+        
+        *transport_router_proto.add_stop_to_router() = std::move(router_by_stop_proto);
+    }
+    
+    const auto& edge_id_to_edge = transport_router.GetEdgeIdToEdge();
+    
+    for (size_t edge_id = 0; edge_id < edge_id_to_edge.size(); ++edge_id) {
+        
+        transport_catalogue_protobuf::EdgeInfo edge_info_proto;
+        const auto& edge_info = edge_id_to_edge.at(edge_id);
+        
+        if (std::holds_alternative<domain::StopEdge>(edge_info)) {
+            const auto& stop_edge = std::get<domain::StopEdge>(edge_info);
+            
+            edge_info_proto.mutable_stop_edge()->set_stop_id(transport_catalogue.GetStop(stop_edge.name).value());
+            edge_info_proto.mutable_stop_edge()->set_time(stop_edge.time);
+            
+        } else {
+            const auto& bus_edge = std::get<domain::BusEdge>(edge_info);
+            
+            edge_info_proto.mutable_bus_edge()->set_bus_id(transport_catalogue.GetBus(bus_edge.bus_name).value());
+            edge_info_proto.mutable_bus_edge()->set_span_count(bus_edge.span_count);
+            edge_info_proto.mutable_bus_edge()->set_time(bus_edge.time);
+        }
+        
+        *transport_router_proto.add_edge_id_to_edge() = std::move(edge_info_proto);
+    }
+    
+    return transport_router_proto;
+}
+    
+void DeserializationTransportRouter(const transport_catalogue_protobuf::TransportRouter& transport_router_proto,
+                                     transport_catalogue::TransportCatalogue& transport_catalogue,
+                                     transport_catalogue::detail::router::TransportRouter& transport_router) {
+    
+    const auto stops_count = transport_catalogue.GetStopsCount();
+    const auto buses_count = transport_catalogue.GetBusesCount();
+    
+    // every stop owns two vertices, checked before the graph allocates its lists
+    if (transport_router_proto.graph().vertex_count() != 2 * stops_count) {
+        throw std::runtime_error("corrupted graph in serialized file");
+    }
+    
+    std::vector<domain::RouterByStop> stop_to_router(stops_count);
+    
+    for (const auto& router_by_stop_proto : transport_router_proto.stop_to_router()) {
+        
+        if (router_by_stop_proto.stop_id() >= stops_count) {
+            throw std::runtime_error("corrupted router stops in serialized file");
+        }
+        
+        stop_to_router[router_by_stop_proto.stop_id()] = domain::RouterByStop{router_by_stop_proto.bus_wait_start(), 
+                                                                              router_by_stop_proto.bus_wait_end()};
+    }
+    
+    std::vector<std::variant<domain::StopEdge, domain::BusEdge>> edge_id_to_edge;
+    edge_id_to_edge.reserve(transport_router_proto.edge_id_to_edge_size());
+    
+    for (const auto& edge_info_proto : transport_router_proto.edge_id_to_edge()) {
+        
+        if (edge_info_proto.has_stop_edge()) {
+            const auto& stop_edge_proto = edge_info_proto.stop_edge();
+            
+            if (stop_edge_proto.stop_id() >= stops_count) {
+                throw std::runtime_error("corrupted router edges in serialized file");
+            }
+            
+            edge_id_to_edge.emplace_back(domain::StopEdge{transport_catalogue.GetStopName(stop_edge_proto.stop_id()), 
+                                                          stop_edge_proto.time()});
+            
+        } else {
+            const auto& bus_edge_proto = edge_info_proto.bus_edge();
+            
+            if (bus_edge_proto.bus_id() >= buses_count) {
+                throw std::runtime_error("corrupted router edges in serialized file");
+            }
+            
+            edge_id_to_edge.emplace_back(domain::BusEdge{transport_catalogue.GetBusName(bus_edge_proto.bus_id()), 
+                                                         bus_edge_proto.span_count(), 
+                                                         bus_edge_proto.time()});
+        }
+    }
+    
+    transport_router.SetStopToVertex(std::move(stop_to_router));
+    transport_router.SetEdgeIdToEdge(std::move(edge_id_to_edge));
+    transport_router.SetGraph(DeserializationGraph(transport_router_proto.graph()));
+    
+    // GetEdge indexes the edges by id, so every graph edge needs its own
+    if (transport_router.GetEdgeIdToEdge().size() != transport_router.GetGraph().GetEdgeCount()) {
+        throw std::runtime_error("corrupted router edges in serialized file");
+    }
+    
+    if (transport_router_proto.has_router()) {
+        transport_router.SetRouter(DeserializationRouter(transport_router_proto.router()));
+    } else if (transport_router_proto.has_contraction_hierarchy()) {
+        transport_router.SetContractionHierarchy(DeserializationContractionHierarchy(transport_router_proto.contraction_hierarchy()));
+    } else {
+        transport_router.BuildRoutingEngine();
+    }
+}
+    
+void DeserializationCatalogueRouter(const transport_catalogue_protobuf::Catalogue& catalogue_proto, Catalogue& catalogue) {
+    
+    catalogue.transport_router_.SetRoutingSettings(DeserializationRoutingSettings(catalogue_proto.routing_settings()));
+    
+    if (catalogue_proto.has_transport_router()) {
+        DeserializationTransportRouter(catalogue_proto.transport_router(), 
+                                       catalogue.transport_catalogue_, 
+                                       catalogue.transport_router_);
+    } else {
+        catalogue.transport_router_.BuildRouter(catalogue.transport_catalogue_);
+    }
+}
+    
 void SerializationCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue, 
                              const map_renderer::RenderSettings& render_settings, 
-                             const domain::RoutingSettings& routing_settings, 
+                             const std::string& rendered_map,
+                             const transport_catalogue::detail::router::TransportRouter& transport_router, 
+                             bool compact,
                              std::ostream& out) {
     
     transport_catalogue_protobuf::Catalogue catalogue_proto;
  
-    transport_catalogue_protobuf::TransportCatalogue transport_catalogue_proto = SerializationTransportCatalogue(transport_catalogue);
+    transport_catalogue_protobuf::TransportCatalogue transport_catalogue_proto = SerializationTransportCatalogue(transport_catalogue, compact);
     transport_catalogue_protobuf::RenderSettings render_settings_proto = SerializationRenderSettings(render_settings);
-    transport_catalogue_protobuf::RoutingSettings routing_settings_proto = SerializationRoutingSettings(routing_settings);
+    transport_catalogue_protobuf::RoutingSettings routing_settings_proto = SerializationRoutingSettings(transport_router.GetRoutingSettings());
  
     *catalogue_proto.mutable_transport_catalogue() = std::move(transport_catalogue_proto);
     *catalogue_proto.mutable_render_settings() = std::move(render_settings_proto);
     *catalogue_proto.mutable_routing_settings() = std::move(routing_settings_proto);
+    catalogue_proto.set_rendered_map(rendered_map);
+    
+    // the raptor engine works on the catalogue itself and is rebuilt when the base is loaded
+    if (transport_router.GetRoutingSettings().router_engine != domain::RouterEngine::RAPTOR) {
+        *catalogue_proto.mutable_transport_router() = SerializationTransportRouter(transport_catalogue, transport_router);
+    }
     
     catalogue_proto.SerializePartialToOstream(&out);
  
@@ -297,9 +853,38 @@ Catalogue DeserializationCatalogue(std::istream& in) {
         throw std::runtime_error("cannot parse serialized file from istream");
     }
     
-    return {DeserializationTransportCatalogue(catalogue_proto.transport_catalogue()),
-            DeserializationRenderSettings(catalogue_proto.render_settings()),
-            DeserializationRoutingSettings(catalogue_proto.routing_settings())};
+    Catalogue catalogue{{},
+                        DeserializationTransportCatalogue(catalogue_proto.transport_catalogue()),
+                        DeserializationRenderSettings(catalogue_proto.render_settings()),
+                        {},
+                        catalogue_proto.rendered_map(),
+                        {}};
+    
+    DeserializationCatalogueRouter(catalogue_proto, catalogue);
+    
+    return catalogue;
+}
+    
+Catalogue DeserializationCatalogue(const std::string& file_name) {
+    
+    if (IsFlatCatalogue(file_name)) {
+        return DeserializationFlatCatalogue(file_name);
+    }
+    
+    std::ifstream in_file(file_name, std::ios::binary);
+    return DeserializationCatalogue(in_file);
+}
+    
+void LoadCatalogueSection(Catalogue& catalogue, domain::BaseSection section) {
+    
+    const auto it = std::find(catalogue.pending_sections_.begin(), catalogue.pending_sections_.end(), section);
+    
+    if (it == catalogue.pending_sections_.end()) {
+        return;
+    }
+    
+    catalogue.pending_sections_.erase(it);
+    LoadFlatSection(catalogue, section);
 }
     
 } // namespace serialization
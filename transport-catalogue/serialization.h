@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <string>
 
 #include "transport_catalogue.h"
 #include "transport_catalogue.pb.h"
@@ -9,23 +11,51 @@
 #include "map_renderer.pb.h"
 #include "transport_router.h"
 #include "transport_router.pb.h"
+#include "graph.pb.h"
  
 namespace serialization {
     
+enum class BaseFormat {
+    PROTOBUF,
+    // fixed-width tables read in place from a mapped file, see flat_serialization.h
+    FLAT
+};
+    
 struct SerializationSettings {
     std::string file_name;
+    BaseFormat format = BaseFormat::PROTOBUF;
+    // protobuf only: fixed-point, delta-coded coordinates, stop ids and distances
+    bool compact = false;
 };
     
+class MappedFile;
+    
 struct Catalogue {
+    // the mapped flat base the catalogue's names point into, empty for a protobuf base
+    std::shared_ptr<const MappedFile> base_file_;
     transport_catalogue::TransportCatalogue transport_catalogue_;
     map_renderer::RenderSettings render_settings_;
-    domain::RoutingSettings routing_settings_;
+    transport_catalogue::detail::router::TransportRouter transport_router_;
+    // empty when the base was saved without a map
+    std::string rendered_map_;
+    // sections still waiting in base_file_, see LoadCatalogueSection
+    std::vector<domain::BaseSection> pending_sections_;
 };
     
-template <typename It>
-uint32_t calculate_id(It start, It end, std::string_view name);
+transport_catalogue_protobuf::TransportCatalogue SerializationTransportCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue, bool compact);
+    
+// throw when a saved index does not fit the catalogue it was saved with
+void CheckNameOrder(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                    const transport_catalogue::Table<domain::StopId>& stops_by_name,
+                    const transport_catalogue::Table<domain::BusId>& buses_by_name);
+void CheckStopBuses(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                    const transport_catalogue::Table<uint32_t>& offsets,
+                    const transport_catalogue::Table<domain::BusId>& bus_ids);
+void CheckStopGrid(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                   const transport_catalogue::StopGrid::Layout& layout,
+                   const transport_catalogue::Table<uint32_t>& cell_offsets,
+                   const transport_catalogue::Table<domain::StopId>& stop_ids);
     
-transport_catalogue_protobuf::TransportCatalogue SerializationTransportCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue);
 transport_catalogue::TransportCatalogue DeserializationTransportCatalogue(const transport_catalogue_protobuf::TransportCatalogue& transport_catalogue_proto);
  
 transport_catalogue_protobuf::Color SerializationColor(const svg::Color& tc_color);
@@ -36,11 +66,33 @@ map_renderer::RenderSettings DeserializationRenderSettings(const transport_catal
 transport_catalogue_protobuf::RoutingSettings SerializationRoutingSettings(const domain::RoutingSettings& routing_settings);
 domain::RoutingSettings DeserializationRoutingSettings(const transport_catalogue_protobuf::RoutingSettings& routing_settings_proto);
  
+graph_serialize::Graph SerializationGraph(const graph::DirectedWeightedGraph<double>& graph);
+graph::DirectedWeightedGraph<double> DeserializationGraph(const graph_serialize::Graph& graph_proto);
+graph_serialize::Router SerializationRouter(const graph::Router<double>& router);
+graph::Router<double>::RoutesInternalData DeserializationRouter(const graph_serialize::Router& router_proto);
+graph_serialize::ContractionHierarchy SerializationContractionHierarchy(const graph::ContractionHierarchyRouter<double>& router);
+graph::ContractionHierarchyRouter<double>::HierarchyInternalData DeserializationContractionHierarchy(const graph_serialize::ContractionHierarchy& contraction_hierarchy_proto);
+    
+transport_catalogue_protobuf::TransportRouter SerializationTransportRouter(const transport_catalogue::TransportCatalogue& transport_catalogue,
+                                                                           const transport_catalogue::detail::router::TransportRouter& transport_router);
+void DeserializationTransportRouter(const transport_catalogue_protobuf::TransportRouter& transport_router_proto,
+                                     transport_catalogue::TransportCatalogue& transport_catalogue,
+                                     transport_catalogue::detail::router::TransportRouter& transport_router);
+ 
+// routing settings and the saved router, or a router built anew when none was saved
+void DeserializationCatalogueRouter(const transport_catalogue_protobuf::Catalogue& catalogue_proto, Catalogue& catalogue);
+ 
 void SerializationCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue, 
                              const map_renderer::RenderSettings& render_settings,
-                             const domain::RoutingSettings& routing_settings,
+                             const std::string& rendered_map,
+                             const transport_catalogue::detail::router::TransportRouter& transport_router,
+                             bool compact,
                              std::ostream& out); 
     
 Catalogue DeserializationCatalogue(std::istream& in);
+// either format, told apart by the file's first bytes
+Catalogue DeserializationCatalogue(const std::string& file_name);
+// loads a section left pending by the loader, does nothing when it is already loaded
+void LoadCatalogueSection(Catalogue& catalogue, domain::BaseSection section);
     
 } // namespace serialization
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+ 
+#include "serialization.h"
+ 
+using namespace std;
+ 
+using namespace transport_catalogue;
+using namespace transport_catalogue::detail::router;
+ 
+using namespace map_renderer;
+using namespace serialization;
+ 
+// times saving and loading generated bases of growing size:
+// serialization_benchmark [max_stops_count]
+ 
+namespace {
+ 
+const size_t STOPS_PER_BUS = 20;
+const size_t MIN_STOPS_COUNT = 1000;
+const size_t DEFAULT_MAX_STOPS_COUNT = 100000;
+ 
+// stops scattered over a city-sized box, a roundtrip bus for every STOPS_PER_BUS / 2 stops,
+// a road distance for every pair of consecutive stops of a bus
+TransportCatalogue MakeCatalogue(size_t stops_count) {
+    TransportCatalogue catalogue;
+    mt19937 generator(static_cast<uint32_t>(stops_count));
+    
+    uniform_real_distribution<double> latitude(55.5, 55.9);
+    uniform_real_distribution<double> longitude(37.3, 37.9);
+    uniform_int_distribution<StopId> stop(0, static_cast<StopId>(stops_count - 1));
+    uniform_int_distribution<int> distance(500, 5000);
+    
+    for (size_t i = 0; i < stops_count; ++i) {
+        catalogue.AddStop({"Stop "s + to_string(i), latitude(generator), longitude(generator)});
+    }
+    
+    const size_t buses_count = 2 * stops_count / STOPS_PER_BUS;
+    vector<Bus> buses;
+    buses.reserve(buses_count);
+    
+    for (size_t i = 0; i < buses_count; ++i) {
+        Bus bus{"Bus "s + to_string(i), {}, true, nullopt, {}};
+        
+        for (size_t j = 0; j < STOPS_PER_BUS; ++j) {
+            bus.stops.push_back(stop(generator));
+        }
+        
+        bus.stops.push_back(bus.stops.front());
+        
+        vector<Distance> distances;
+        for (size_t j = 1; j < bus.stops.size(); ++j) {
+            distances.push_back({bus.stops[j - 1], bus.stops[j], distance(generator)});
+        }
+        
+        catalogue.AddDistance(distances);
+        buses.push_back(move(bus));
+    }
+    
+    for (Bus& bus : buses) {
+        catalogue.AddBus(move(bus));
+    }
+    
+    catalogue.BuildNameOrder();
+    catalogue.BuildStopBuses();
+    catalogue.BuildStopGrid();
+    catalogue.BuildNameIndex();
+    
+    return catalogue;
+}
+ 
+template <typename Function>
+double MeasureMilliseconds(Function function) {
+    const auto start = chrono::steady_clock::now();
+    function();
+    
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+ 
+void RunBenchmark(size_t stops_count, bool compact, ostream& out) {
+    TransportCatalogue transport_catalogue = MakeCatalogue(stops_count);
+    
+    RoutingSettings routing_settings;
+    routing_settings.bus_wait_time = 6;
+    routing_settings.bus_velocity = 40;
+    // the graph alone is saved, so the router does not outweigh the catalogue
+    routing_settings.router_engine = RouterEngine::DIJKSTRA;
+    
+    TransportRouter transport_router;
+    transport_router.SetRoutingSettings(routing_settings);
+    transport_router.BuildRouter(transport_catalogue);
+    
+    const RenderSettings render_settings{};
+    
+    transport_catalogue_protobuf::TransportCatalogue transport_catalogue_proto;
+    const double save_catalogue = MeasureMilliseconds([&] {
+        transport_catalogue_proto = SerializationTransportCatalogue(transport_catalogue, compact);
+    });
+    
+    const double load_catalogue = MeasureMilliseconds([&] {
+        DeserializationTransportCatalogue(transport_catalogue_proto);
+    });
+    
+    ostringstream base;
+    const double save_base = MeasureMilliseconds([&] {
+        SerializationCatalogue(transport_catalogue, render_settings, {}, transport_router, compact, base);
+    });
+    
+    const string base_bytes = base.str();
+    istringstream in(base_bytes);
+    
+    const double load_base = MeasureMilliseconds([&] {
+        DeserializationCatalogue(in);
+    });
+    
+    out << setw(10) << stops_count
+        << setw(10) << (compact ? "compact"sv : "plain"sv)
+        << setw(12) << base_bytes.size()
+        << fixed << setprecision(1)
+        << setw(14) << save_catalogue
+        << setw(14) << load_catalogue
+        << setw(12) << save_base
+        << setw(12) << load_base << '\n';
+}
+ 
+} // namespace
+ 
+int main(int argc, char* argv[]) {
+ 
+    if (argc > 2) {
+        cerr << "Usage: serialization_benchmark [max_stops_count]\n"sv;
+        return 1;
+    }
+    
+    const size_t max_stops_count = argc == 2 ? strtoull(argv[1], nullptr, 10) : DEFAULT_MAX_STOPS_COUNT;
+    
+    // milliseconds; catalogue is SerializationTransportCatalogue and its inverse,
+    // base is the whole base with the router through SerializationCatalogue and DeserializationCatalogue
+    cout << setw(10) << "stops"sv
+         << setw(10) << "encoding"sv
+         << setw(12) << "bytes"sv
+         << setw(14) << "save catalog"sv
+         << setw(14) << "load catalog"sv
+         << setw(12) << "save base"sv
+         << setw(12) << "load base"sv << '\n';
+    
+    for (size_t stops_count = MIN_STOPS_COUNT; stops_count <= max_stops_count; stops_count *= 10) {
+        RunBenchmark(stops_count, false, cout);
+        RunBenchmark(stops_count, true, cout);
+    }
+}
@@ -0,0 +1,267 @@
+#include "stop_grid.h"
+ 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+ 
+namespace transport_catalogue {
+ 
+namespace {
+ 
+// the search box is widened by this many degrees, so a stop lying exactly on the radius is never cut off by rounding
+constexpr double BOX_MARGIN = 1e-6;
+ 
+void SortByDistance(std::vector<domain::NearbyStop>& stops) {
+    std::sort(stops.begin(), stops.end(), [](const domain::NearbyStop& lhs, const domain::NearbyStop& rhs) {
+        return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.stop < rhs.stop);
+    });
+}
+ 
+} // namespace
+ 
+StopGrid::StopGrid(const Table<geo::Coordinates>& coordinates, const Table<geo::SpherePoint>& points) {
+ 
+    if (coordinates.empty()) {
+        return;
+    }
+    
+    const auto [min_latitude, max_latitude] = std::minmax_element(coordinates.begin(), coordinates.end(),
+        [](const geo::Coordinates& lhs, const geo::Coordinates& rhs) {return lhs.latitude < rhs.latitude;});
+    const auto [min_longitude, max_longitude] = std::minmax_element(coordinates.begin(), coordinates.end(),
+        [](const geo::Coordinates& lhs, const geo::Coordinates& rhs) {return lhs.longitude < rhs.longitude;});
+    
+    const uint32_t side = std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(std::sqrt(coordinates.size()))));
+    
+    layout_.min = {min_latitude->latitude, min_longitude->longitude};
+    layout_.rows = side;
+    layout_.cols = side;
+    layout_.cell_height = (max_latitude->latitude - min_latitude->latitude) / side;
+    layout_.cell_width = (max_longitude->longitude - min_longitude->longitude) / side;
+    
+    // all stops on one parallel or meridian still need a usable cell size
+    if (layout_.cell_height <= 0.) {
+        layout_.cell_height = 1.;
+    }
+    
+    if (layout_.cell_width <= 0.) {
+        layout_.cell_width = 1.;
+    }
+    
+    std::vector<uint32_t> stop_cells(coordinates.size());
+    std::vector<uint32_t> cell_offsets(static_cast<size_t>(side) * side + 1, 0);
+    
+    for (domain::StopId stop = 0; stop < coordinates.size(); ++stop) {
+        stop_cells[stop] = GetRow(coordinates[stop].latitude) * side + GetCol(coordinates[stop].longitude);
+        ++cell_offsets[stop_cells[stop] + 1];
+    }
+    
+    for (size_t cell = 1; cell < cell_offsets.size(); ++cell) {
+        cell_offsets[cell] += cell_offsets[cell - 1];
+    }
+    
+    std::vector<uint32_t> cell_fill(cell_offsets.begin(), cell_offsets.end() - 1);
+    std::vector<domain::StopId> stop_ids(coordinates.size());
+    std::vector<geo::SpherePoint> stop_points(coordinates.size());
+    
+    for (domain::StopId stop = 0; stop < coordinates.size(); ++stop) {
+        const uint32_t position = cell_fill[stop_cells[stop]]++;
+        
+        stop_ids[position] = stop;
+        stop_points[position] = points[stop];
+    }
+    
+    cell_offsets_ = std::move(cell_offsets);
+    stop_ids_ = std::move(stop_ids);
+    stop_points_ = std::move(stop_points);
+}
+ 
+StopGrid::StopGrid(const Layout& layout,
+                   Table<uint32_t>&& cell_offsets,
+                   Table<domain::StopId>&& stop_ids,
+                   const Table<geo::SpherePoint>& points) : layout_(layout)
+                                                          , cell_offsets_(std::move(cell_offsets))
+                                                          , stop_ids_(std::move(stop_ids)) {
+    
+    std::vector<geo::SpherePoint> stop_points;
+    stop_points.reserve(stop_ids_.size());
+    
+    for (domain::StopId stop : stop_ids_) {
+        stop_points.push_back(points[stop]);
+    }
+    
+    stop_points_ = std::move(stop_points);
+}
+ 
+StopGrid::StopGrid(const Layout& layout,
+                   Table<uint32_t>&& cell_offsets,
+                   Table<domain::StopId>&& stop_ids,
+                   Table<geo::SpherePoint>&& stop_points) : layout_(layout)
+                                                          , cell_offsets_(std::move(cell_offsets))
+                                                          , stop_ids_(std::move(stop_ids))
+                                                          , stop_points_(std::move(stop_points)) {}
+ 
+std::vector<domain::NearbyStop> StopGrid::FindNearest(geo::Coordinates point, size_t count) const {
+    std::vector<domain::NearbyStop> candidates;
+    
+    if (empty() || count == 0) {
+        return candidates;
+    }
+    
+    const geo::SpherePoint sphere_point = geo::ToSpherePoint(point);
+    const double any_distance = std::numeric_limits<double>::infinity();
+    std::vector<double> distances;
+    
+    const uint32_t row = GetRow(point.latitude);
+    const uint32_t col = GetCol(point.longitude);
+    const uint32_t rings_count = std::max(layout_.rows, layout_.cols);
+    
+    // square rings of cells around the point's cell until count stops are seen
+    for (uint32_t ring = 0; ring < rings_count && candidates.size() < count; ++ring) {
+        const uint32_t first_row = row >= ring ? row - ring : 0;
+        const uint32_t last_row = std::min(row + ring, layout_.rows - 1);
+        const uint32_t first_col = col >= ring ? col - ring : 0;
+        const uint32_t last_col = std::min(col + ring, layout_.cols - 1);
+        
+        for (uint32_t cell_row = first_row; cell_row <= last_row; ++cell_row) {
+        
+            if (cell_row + ring == row || cell_row == row + ring) {
+                CollectStops(sphere_point, cell_row, first_col, last_col, any_distance, distances, candidates);
+            
+            } else {
+            
+                if (col >= ring) {
+                    CollectStops(sphere_point, cell_row, col - ring, col - ring, any_distance, distances, candidates);
+                }
+                
+                if (col + ring < layout_.cols) {
+                    CollectStops(sphere_point, cell_row, col + ring, col + ring, any_distance, distances, candidates);
+                }
+            }
+        }
+    }
+    
+    if (candidates.size() < count) {
+        SortByDistance(candidates);
+        return candidates;
+    }
+    
+    // the ring square is not a circle: a closer stop may sit in a cell just outside it,
+    // but none can be farther than the count-th candidate seen so far
+    std::nth_element(candidates.begin(), candidates.begin() + (count - 1), candidates.end(),
+                     [](const domain::NearbyStop& lhs, const domain::NearbyStop& rhs) {return lhs.distance < rhs.distance;});
+    
+    std::vector<domain::NearbyStop> result = FindInRadius(point, candidates[count - 1].distance);
+    result.resize(std::min(result.size(), count));
+    
+    return result;
+}
+ 
+std::vector<domain::NearbyStop> StopGrid::FindInRadius(geo::Coordinates point, double radius) const {
+    std::vector<domain::NearbyStop> result;
+    
+    if (empty() || radius < 0.) {
+        return result;
+    }
+    
+    const CellRange box = GetSearchBox(point, radius);
+    const geo::SpherePoint sphere_point = geo::ToSpherePoint(point);
+    std::vector<double> distances;
+    
+    for (uint32_t row = box.first_row; row <= box.last_row; ++row) {
+        CollectStops(sphere_point, row, box.first_col, box.last_col, radius, distances, result);
+    }
+    
+    SortByDistance(result);
+    
+    return result;
+}
+ 
+const StopGrid::Layout& StopGrid::GetLayout() const {
+    return layout_;
+}
+ 
+const Table<uint32_t>& StopGrid::GetCellOffsets() const {
+    return cell_offsets_;
+}
+ 
+const Table<domain::StopId>& StopGrid::GetStopIds() const {
+    return stop_ids_;
+}
+ 
+const Table<geo::SpherePoint>& StopGrid::GetStopPoints() const {
+    return stop_points_;
+}
+ 
+bool StopGrid::empty() const {
+    return stop_ids_.empty();
+}
+ 
+uint32_t StopGrid::GetRow(double latitude) const {
+    const double row = std::floor((latitude - layout_.min.latitude) / layout_.cell_height);
+    return static_cast<uint32_t>(std::clamp(row, 0., static_cast<double>(layout_.rows - 1)));
+}
+ 
+uint32_t StopGrid::GetCol(double longitude) const {
+    const double col = std::floor((longitude - layout_.min.longitude) / layout_.cell_width);
+    return static_cast<uint32_t>(std::clamp(col, 0., static_cast<double>(layout_.cols - 1)));
+}
+ 
+StopGrid::CellRange StopGrid::GetSearchBox(geo::Coordinates point, double radius) const {
+    static const double dr = M_PI / 180.;
+    
+    CellRange box = {0, layout_.rows - 1, 0, layout_.cols - 1};
+    const double angle = radius / geo::EARTH_RADIUS;
+    
+    if (angle >= M_PI / 2.) {
+        return box;
+    }
+    
+    const double latitude_delta = angle / dr + BOX_MARGIN;
+    
+    box.first_row = GetRow(point.latitude - latitude_delta);
+    box.last_row = GetRow(point.latitude + latitude_delta);
+    
+    // the widest longitude span of a circle around the point, unless the circle reaches a pole;
+    // a box crossing the antimeridian keeps every column
+    const double sin_angle = std::sin(angle);
+    const double cos_latitude = std::cos(point.latitude * dr);
+    
+    if (std::abs(point.latitude) + latitude_delta >= 90. || sin_angle >= cos_latitude) {
+        return box;
+    }
+    
+    const double longitude_delta = std::asin(sin_angle / cos_latitude) / dr + BOX_MARGIN;
+    
+    if (point.longitude - longitude_delta >= -180. && point.longitude + longitude_delta <= 180.) {
+        box.first_col = GetCol(point.longitude - longitude_delta);
+        box.last_col = GetCol(point.longitude + longitude_delta);
+    }
+    
+    return box;
+}
+ 
+void StopGrid::CollectStops(const geo::SpherePoint& point,
+                            uint32_t row,
+                            uint32_t first_col,
+                            uint32_t last_col,
+                            double radius,
+                            std::vector<double>& distances,
+                            std::vector<domain::NearbyStop>& stops) const {
+    
+    // cells of one row are adjacent in the CSR arrays
+    const size_t row_begin = static_cast<size_t>(row) * layout_.cols;
+    const uint32_t first = cell_offsets_[row_begin + first_col];
+    const uint32_t last = cell_offsets_[row_begin + last_col + 1];
+    
+    distances.resize(last - first);
+    geo::ComputeDistances(point, stop_points_.data() + first, last - first, distances.data());
+    
+    for (uint32_t i = first; i < last; ++i) {
+        
+        if (distances[i - first] <= radius) {
+            stops.push_back({stop_ids_[i], distances[i - first]});
+        }
+    }
+}
+ 
+} // namespace transport_catalogue
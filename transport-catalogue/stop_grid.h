@@ -0,0 +1,83 @@
+#pragma once
+ 
+#include <cstdint>
+#include <vector>
+ 
+#include "domain.h"
+#include "geo.h"
+#include "table.h"
+ 
+namespace transport_catalogue {
+ 
+// uniform latitude/longitude grid over the stops in CSR form: the stops of cell (row, col)
+// are stop_ids[cell_offsets[row * cols + col]..cell_offsets[row * cols + col + 1]),
+// their sphere points are kept next to them, so a query only reads the cells its search box
+// overlaps, and a run of cells in one row is measured in a single batch
+class StopGrid {
+public:
+    struct Layout {
+        // south-west corner of the grid
+        geo::Coordinates min = {0., 0.};
+        // degrees of latitude and longitude per cell
+        double cell_height = 0.;
+        double cell_width = 0.;
+        uint32_t rows = 0;
+        uint32_t cols = 0;
+    };
+    
+    StopGrid() = default;
+    
+    // about one stop per cell, points[stop] is geo::ToSpherePoint(coordinates[stop])
+    StopGrid(const Table<geo::Coordinates>& coordinates, const Table<geo::SpherePoint>& points);
+    
+    // restores a saved grid, points[stop] as above
+    StopGrid(const Layout& layout,
+             Table<uint32_t>&& cell_offsets,
+             Table<domain::StopId>&& stop_ids,
+             const Table<geo::SpherePoint>& points);
+    
+    // restores a saved grid together with its points, already in stop_ids order
+    StopGrid(const Layout& layout,
+             Table<uint32_t>&& cell_offsets,
+             Table<domain::StopId>&& stop_ids,
+             Table<geo::SpherePoint>&& stop_points);
+    
+    // both are ordered by distance, then by stop id
+    std::vector<domain::NearbyStop> FindNearest(geo::Coordinates point, size_t count) const;
+    std::vector<domain::NearbyStop> FindInRadius(geo::Coordinates point, double radius) const;
+    
+    const Layout& GetLayout() const;
+    const Table<uint32_t>& GetCellOffsets() const;
+    const Table<domain::StopId>& GetStopIds() const;
+    const Table<geo::SpherePoint>& GetStopPoints() const;
+    
+    bool empty() const;
+ 
+private:
+    struct CellRange {
+        uint32_t first_row;
+        uint32_t last_row;
+        uint32_t first_col;
+        uint32_t last_col;
+    };
+    
+    uint32_t GetRow(double latitude) const;
+    uint32_t GetCol(double longitude) const;
+    CellRange GetSearchBox(geo::Coordinates point, double radius) const;
+    
+    // appends the stops of cells (row, first_col..last_col) no farther than radius from point
+    void CollectStops(const geo::SpherePoint& point,
+                      uint32_t row,
+                      uint32_t first_col,
+                      uint32_t last_col,
+                      double radius,
+                      std::vector<double>& distances,
+                      std::vector<domain::NearbyStop>& stops) const;
+    
+    Layout layout_;
+    Table<uint32_t> cell_offsets_;
+    Table<domain::StopId> stop_ids_;
+    Table<geo::SpherePoint> stop_points_;
+};
+ 
+} // namespace transport_catalogue
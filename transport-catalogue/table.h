@@ -0,0 +1,98 @@
+#pragma once
+ 
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+ 
+namespace transport_catalogue {
+ 
+// a catalogue table: elements either owned by the table or viewed in place, e.g. in a mapped base;
+// readers see one contiguous span either way, the first change to a viewed table copies it
+template <typename T>
+class Table {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "a table can view only plain data");
+    
+    Table() = default;
+    Table(std::vector<T>&& elements) : elements_(std::move(elements))
+                                     , data_(elements_.data())
+                                     , size_(elements_.size()) {}
+    
+    // the viewed elements must outlive the table and every copy of it
+    static Table View(const T* data, size_t size) {
+        Table table;
+        table.data_ = data;
+        table.size_ = size;
+        return table;
+    }
+    
+    Table(const Table& other) : elements_(other.elements_)
+                              , data_(other.IsOwned() ? elements_.data() : other.data_)
+                              , size_(other.size_) {}
+    
+    // moving a vector keeps its buffer, so an owned table's span stays valid
+    Table(Table&& other) noexcept : elements_(std::move(other.elements_))
+                                  , data_(other.data_)
+                                  , size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    
+    Table& operator=(Table other) noexcept {
+        std::swap(elements_, other.elements_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+    
+    const T* begin() const {return data_;}
+    const T* end() const {return data_ + size_;}
+    const T* data() const {return data_;}
+    
+    size_t size() const {return size_;}
+    bool empty() const {return size_ == 0;}
+    
+    const T& operator[](size_t index) const {return data_[index];}
+    const T& back() const {return data_[size_ - 1];}
+    
+    T* MutableData() {
+        Own();
+        return elements_.data();
+    }
+    
+    void push_back(const T& element) {
+        Own();
+        elements_.push_back(element);
+        Sync();
+    }
+    
+    template <typename It>
+    void append(It first, It last) {
+        Own();
+        elements_.insert(elements_.end(), first, last);
+        Sync();
+    }
+ 
+private:
+    bool IsOwned() const {return data_ == elements_.data();}
+    
+    void Own() {
+    
+        if (!IsOwned()) {
+            elements_.assign(data_, data_ + size_);
+            Sync();
+        }
+    }
+    
+    void Sync() {
+        data_ = elements_.data();
+        size_ = elements_.size();
+    }
+    
+    std::vector<T> elements_;
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+};
+ 
+} // namespace transport_catalogue
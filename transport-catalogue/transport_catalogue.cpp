@@ -1,139 +1,469 @@
 #include "transport_catalogue.h"
  
+#include <algorithm>
+ 
 namespace transport_catalogue {  
     
-void TransportCatalogue::AddStop(Stop&& stop) {
-    stops.push_back(std::move(stop));
-    Stop* stop_buf = &stops.back();
-    stopname_to_stop.insert(transport_catalogue::StopMap::value_type(stop_buf->name, stop_buf));
+template <typename Id>
+ranges::Range<const Id*> FindByPrefix(const Table<Id>& ids_by_name, const NameTable& names, std::string_view prefix) {
+    
+    const auto first = std::lower_bound(ids_by_name.begin(), ids_by_name.end(), prefix, 
+                                        [&names](Id id, std::string_view prefix) {
+                                            return names[id] < prefix;
+                                        });
+    
+    const auto last = std::upper_bound(first, ids_by_name.end(), prefix, 
+                                       [&names](std::string_view prefix, Id id) {
+                                           return prefix < names[id].substr(0, prefix.size());
+                                       });
+    
+    return {first, last};
 }
- 
-void TransportCatalogue::AddBus(Bus&& bus) {
-    Bus* bus_buf;
     
-    buses.push_back(std::move(bus)); 
-    bus_buf = &buses.back();
-    busname_to_bus.insert(BusMap::value_type(bus_buf->name, bus_buf));
+template <typename Id>
+std::optional<Id> FindInNameMap(const std::unordered_multimap<size_t, Id>& name_map, 
+                                const NameTable& names, 
+                                std::string_view name) {
+    
+    const auto [first, last] = name_map.equal_range(std::hash<std::string_view>{}(name));
+    
+    for (auto it = first; it != last; ++it) {
+        
+        if (names[it->second] == name) {
+            return it->second;
+        }
+    }
+    return std::nullopt;
+}
+    
+StopId TransportCatalogue::AddStop(Stop&& stop) {
+    const StopId stop_id = static_cast<StopId>(stop_names.size());
+    
+    // of equal names the first stop is found, as in the name index
+    if (!FindInNameMap(stopname_to_stop, stop_names, stop.name)) {
+        stopname_to_stop.emplace(std::hash<std::string_view>{}(stop.name), stop_id);
+    }
+    
+    stop_names.Add(stop.name);
+    stop_coordinates.push_back({stop.latitude, stop.longitude});
+    stop_points.push_back(geo::ToSpherePoint(stop_coordinates.back()));
+    
+    return stop_id;
+}
  
-    for (Stop* stop : bus_buf->stops) {
-         stop->buses.push_back(bus_buf);
+BusId TransportCatalogue::AddBus(Bus&& bus) {
+    const BusId bus_id = static_cast<BusId>(bus_names.size());
+    
+    if (!FindInNameMap(busname_to_bus, bus_names, bus.name)) {
+        busname_to_bus.emplace(std::hash<std::string_view>{}(bus.name), bus_id);
     }
     
-    bus_buf->route_length = GetDistanceToBus(bus_buf);
+    bus_names.Add(bus.name);
+    bus_stops.append(bus.stops.begin(), bus.stops.end());
+    bus_stop_offsets.push_back(static_cast<uint32_t>(bus_stops.size()));
+    
+    if (bus.distances.size() == bus.stops.size()) {
+        bus_distances.append(bus.distances.begin(), bus.distances.end());
+        
+    } else {
+        size_t distance = 0;
+        
+        for (size_t i = 0; i < bus.stops.size(); ++i) {
+            
+            if (i > 0) {
+                distance += GetDistanceStop(bus.stops[i - 1], bus.stops[i]);
+            }
+            
+            bus_distances.push_back(distance);
+        }
+    }
+    
+    bus_is_roundtrip.push_back(bus.is_roundtrip);
+    
+    bus_stats.push_back(bus.stats ? *bus.stats : ComputeBusStats(bus_id));
+    
+    return bus_id;
 }
  
 void TransportCatalogue::AddDistance(const std::vector<Distance>& distances) {
     
     for (auto distance : distances) {
-        auto dist_pair = std::make_pair(distance.start, distance.end);
-        distance_to_stop.insert(DistanceMap::value_type(dist_pair, distance.distance));
+        distance_to_stop.Insert(distance.start, distance.end, distance.distance);
     }
 }
  
-Bus* TransportCatalogue::GetBus(std::string_view bus_name) {
-    if (busname_to_bus.empty()) {
-        return nullptr;
-    }
+void TransportCatalogue::SetStops(NameTable&& names, Table<geo::Coordinates>&& coordinates, Table<geo::SpherePoint>&& points) {
+    stop_names = std::move(names);
+    stop_coordinates = std::move(coordinates);
+    stop_points = std::move(points);
+}
+ 
+void TransportCatalogue::SetBuses(NameTable&& names,
+                                  Table<uint32_t>&& stop_offsets,
+                                  Table<StopId>&& stops,
+                                  Table<size_t>&& distances,
+                                  Table<uint8_t>&& is_roundtrip,
+                                  Table<BusStats>&& stats) {
     
-    if (busname_to_bus.count(bus_name)) {
-        return busname_to_bus.at(bus_name);
+    bus_names = std::move(names);
+    bus_stop_offsets = std::move(stop_offsets);
+    bus_stops = std::move(stops);
+    bus_distances = std::move(distances);
+    bus_is_roundtrip = std::move(is_roundtrip);
+    bus_stats = std::move(stats);
+}
+ 
+void TransportCatalogue::SetDistances(DistanceTable&& distances) {
+    distance_to_stop = std::move(distances);
+}
+ 
+void TransportCatalogue::SetNameIndex(NameIndex&& stop_index, NameIndex&& bus_index) {
+    stop_name_index = std::move(stop_index);
+    bus_name_index = std::move(bus_index);
+    
+    StopMap().swap(stopname_to_stop);
+    BusMap().swap(busname_to_bus);
+}
+ 
+std::optional<BusId> TransportCatalogue::GetBus(std::string_view bus_name) const {
+    
+    if (const auto bus = bus_name_index.Find(bus_name, bus_names)) {
+        return bus;
     } else {
-        return nullptr;
+        return FindInNameMap(busname_to_bus, bus_names, bus_name);
     }
 }
     
-Stop* TransportCatalogue::GetStop(std::string_view stop_name) {
-    if (stopname_to_stop.empty()) {
-        return nullptr;
-    }
+std::optional<StopId> TransportCatalogue::GetStop(std::string_view stop_name) const {
     
-    if (stopname_to_stop.count(stop_name)) {
-        return stopname_to_stop.at(stop_name);
+    if (const auto stop = stop_name_index.Find(stop_name, stop_names)) {
+        return stop;
     } else {
-        return nullptr;
+        return FindInNameMap(stopname_to_stop, stop_names, stop_name);
     }
 }
     
-std::deque<Stop> TransportCatalogue::GetStops() const {
-    return stops;
+size_t TransportCatalogue::GetStopsCount() const {
+    return stop_names.size();
 }
     
-std::deque<Bus> TransportCatalogue::GetBuses() const {
-    return buses;
+size_t TransportCatalogue::GetBusesCount() const {
+    return bus_names.size();
 }
     
-BusMap TransportCatalogue::GetBusNameToBus() const {
-    return busname_to_bus;
+const NameTable& TransportCatalogue::GetStopNames() const {
+    return stop_names;
 }
     
-StopMap TransportCatalogue::GetStopNameToStop() const {
-    return stopname_to_stop;
+CoordinatesRange TransportCatalogue::GetStopsCoordinates() const {
+    return ranges::AsRange(stop_coordinates);
+}
+    
+const Table<geo::SpherePoint>& TransportCatalogue::GetStopPoints() const {
+    return stop_points;
+}
+    
+const NameTable& TransportCatalogue::GetBusNames() const {
+    return bus_names;
+}
+    
+std::string_view TransportCatalogue::GetStopName(StopId stop) const {
+    return stop_names[stop];
+}
+    
+const geo::Coordinates& TransportCatalogue::GetStopCoordinates(StopId stop) const {
+    return stop_coordinates[stop];
+}
+    
+BusIdRange TransportCatalogue::GetStopBuses(StopId stop) const {
+    
+    if (stop + 1 >= stop_bus_offsets.size()) {
+        return {};
+    }
+    
+    return BusIdRange(stop_bus_ids.begin() + stop_bus_offsets[stop], 
+                      stop_bus_ids.begin() + stop_bus_offsets[stop + 1]);
+}
+    
+std::string_view TransportCatalogue::GetBusName(BusId bus) const {
+    return bus_names[bus];
+}
+    
+StopIdRange TransportCatalogue::GetBusStops(BusId bus) const {
+    return StopIdRange(bus_stops.begin() + bus_stop_offsets[bus], 
+                       bus_stops.begin() + bus_stop_offsets[bus + 1]);
+}
+    
+size_t TransportCatalogue::GetBusStopsCount(BusId bus) const {
+    return bus_stop_offsets[bus + 1] - bus_stop_offsets[bus];
+}
+    
+RoadDistanceRange TransportCatalogue::GetBusDistances(BusId bus) const {
+    return RoadDistanceRange(bus_distances.begin() + bus_stop_offsets[bus], 
+                             bus_distances.begin() + bus_stop_offsets[bus + 1]);
+}
+    
+bool TransportCatalogue::IsRoundtrip(BusId bus) const {
+    return bus_is_roundtrip[bus] != 0;
 }
- 
-std::unordered_set<const Stop*> TransportCatalogue::GetUniqStops(Bus* bus) {
-    std::unordered_set<const Stop*> unique_stops;   
-    unique_stops.insert(bus->stops.begin(), bus->stops.end());
     
-    return unique_stops;
+size_t TransportCatalogue::GetRouteLength(BusId bus) const {
+    return bus_stats[bus].route_length;
 }
     
-double TransportCatalogue::GetLength(Bus* bus) {
-    return transform_reduce(next(bus->stops.begin()), 
-                            bus->stops.end(), 
-                            bus->stops.begin(),
-                            0.0,
-                            std::plus<>{},
-                            [](const Stop* lhs, const Stop* rhs) { 
-                                return geo::ComputeDistance({(*lhs).latitude,
-                                                              (*lhs).longitude}, {(*rhs).latitude,
-                                                                                  (*rhs).longitude});
-                            });
+const BusStats& TransportCatalogue::GetBusStats(BusId bus) const {
+    return bus_stats[bus];
 }
+    
  
-std::unordered_set<const Bus*> TransportCatalogue::GetStopUniqBuses(Stop* stop){    
-    std::unordered_set<const Bus*> unique_stops;          
-    unique_stops.insert(stop->buses.begin(), stop->buses.end());   
+std::unordered_set<StopId> TransportCatalogue::GetUniqStops(BusId bus) const {
+    const auto stops = GetBusStops(bus);
     
-    return unique_stops;
+    return std::unordered_set<StopId>(stops.begin(), stops.end());
 }
     
-DistanceMap TransportCatalogue::GetDistance() const {
+double TransportCatalogue::GetLength(BusId bus) const {
+    const auto stops = GetBusStops(bus);
+    
+    std::vector<geo::SpherePoint> points;
+    points.reserve(stops.size());
+    
+    for (StopId stop : stops) {
+        points.push_back(stop_points[stop]);
+    }
+    
+    return geo::ComputePathLength(points.data(), points.size());
+}
+ 
+DistanceRange TransportCatalogue::GetDistance() const {
+    return ranges::AsRange(distance_to_stop);
+}
+ 
+const DistanceTable& TransportCatalogue::GetDistanceTable() const {
     return distance_to_stop;
 }
  
-size_t TransportCatalogue::GetDistanceStop(const Stop* begin, const Stop* finish) const {
+std::optional<int> TransportCatalogue::FindDistance(StopId begin, StopId finish) const {
+    return distance_to_stop.Find(begin, finish);
+}
+ 
+size_t TransportCatalogue::GetDistanceStop(StopId begin, StopId finish) const {
+    return distance_to_stop.Find(begin, finish).value_or(0);
+}
+ 
+size_t TransportCatalogue::GetDistanceToBus(BusId bus) const {
     
-    if (distance_to_stop.empty()) {
+    if (bus_stop_offsets[bus] == bus_stop_offsets[bus + 1]) {
         return 0;
+    }
+    
+    return bus_distances[bus_stop_offsets[bus + 1] - 1];
+}
+    
+BusStats TransportCatalogue::ComputeBusStats(BusId bus) const {
+    BusStats stats;
+    
+    stats.stops_on_route = static_cast<uint32_t>(GetBusStopsCount(bus));
+    stats.unique_stops = static_cast<uint32_t>(GetUniqStops(bus).size());
+    stats.route_length = GetDistanceToBus(bus);
+    stats.geo_length = GetLength(bus);
+    stats.curvature = double(stats.route_length / stats.geo_length);
+    
+    return stats;
+}
+    
+void TransportCatalogue::BuildNameIndex() {
+    stop_name_index.Build(stop_names);
+    bus_name_index.Build(bus_names);
+    
+    StopMap().swap(stopname_to_stop);
+    BusMap().swap(busname_to_bus);
+}
+    
+const Table<StopId>& TransportCatalogue::GetStopsByName() const {
+    return stops_by_name;
+}
+    
+const Table<BusId>& TransportCatalogue::GetBusesByName() const {
+    return buses_by_name;
+}
+    
+StopIdRange TransportCatalogue::FindStopsByPrefix(std::string_view prefix) const {
+    return FindByPrefix(stops_by_name, stop_names, prefix);
+}
+    
+BusIdRange TransportCatalogue::FindBusesByPrefix(std::string_view prefix) const {
+    return FindByPrefix(buses_by_name, bus_names, prefix);
+}
+    
+void TransportCatalogue::BuildNameOrder() {
+    std::vector<StopId> stops(stop_names.size());
+    std::iota(stops.begin(), stops.end(), 0);
+    
+    std::sort(stops.begin(), stops.end(), [this](StopId lhs, StopId rhs) {
+        return stop_names[lhs] < stop_names[rhs];
+    });
+    
+    std::vector<BusId> buses(bus_names.size());
+    std::iota(buses.begin(), buses.end(), 0);
+    
+    std::sort(buses.begin(), buses.end(), [this](BusId lhs, BusId rhs) {
+        return bus_names[lhs] < bus_names[rhs];
+    });
+    
+    stops_by_name = std::move(stops);
+    buses_by_name = std::move(buses);
+}
+    
+void TransportCatalogue::SetNameOrder(Table<StopId>&& stops, Table<BusId>&& buses) {
+    stops_by_name = std::move(stops);
+    buses_by_name = std::move(buses);
+}
+    
+void TransportCatalogue::BuildStopBuses() {
+    
+    if (buses_by_name.size() != bus_names.size()) {
+        BuildNameOrder();
+    }
+    
+    // buses are visited in name order, so a repeated stop of the same bus is always the last one seen
+    const BusId no_bus = static_cast<BusId>(bus_names.size());
+    std::vector<BusId> last_bus(stop_names.size(), no_bus);
+    
+    std::vector<uint32_t> offsets(stop_names.size() + 1, 0);
+    
+    for (BusId bus : buses_by_name) {
         
-    } else {
+        for (StopId stop : GetBusStops(bus)) {
+            
+            if (last_bus[stop] != bus) {
+                last_bus[stop] = bus;
+                ++offsets[stop + 1];
+            }
+        }
+    }
+    
+    for (size_t stop = 0; stop < stop_names.size(); ++stop) {
+        offsets[stop + 1] += offsets[stop];
+    }
+    
+    std::vector<uint32_t> stop_fill(offsets.begin(), std::prev(offsets.end()));
+    std::fill(last_bus.begin(), last_bus.end(), no_bus);
+    std::vector<BusId> bus_ids(offsets.back());
+    
+    for (BusId bus : buses_by_name) {
         
-        if (const auto& stop_ptr_pair = std::make_pair(begin, finish);
-            distance_to_stop.count(stop_ptr_pair)) {
+        for (StopId stop : GetBusStops(bus)) {
             
-            return distance_to_stop.at(stop_ptr_pair);
- 
-        } else if (const auto& stop_ptr_pair = std::make_pair(finish, begin);
-                   distance_to_stop.count(stop_ptr_pair)) {
+            if (last_bus[stop] != bus) {
+                last_bus[stop] = bus;
+                bus_ids[stop_fill[stop]++] = bus;
+            }
+        }
+    }
+    
+    stop_bus_offsets = std::move(offsets);
+    stop_bus_ids = std::move(bus_ids);
+}
+    
+void TransportCatalogue::SetStopBuses(Table<uint32_t>&& offsets, Table<BusId>&& bus_ids) {
+    stop_bus_offsets = std::move(offsets);
+    stop_bus_ids = std::move(bus_ids);
+}
+    
+const Table<uint32_t>& TransportCatalogue::GetStopBusOffsets() const {
+    return stop_bus_offsets;
+}
+    
+const Table<BusId>& TransportCatalogue::GetStopBusIds() const {
+    return stop_bus_ids;
+}
+    
+std::vector<DirectConnection> TransportCatalogue::FindDirectConnections(StopId from, StopId to) const {
+    std::vector<DirectConnection> connections;
+    
+    const auto from_buses = GetStopBuses(from);
+    const auto to_buses = GetStopBuses(to);
+    
+    // both bus lists are sorted by name, so the common buses come out of one merge
+    auto from_it = from_buses.begin();
+    auto to_it = to_buses.begin();
+    
+    while (from_it != from_buses.end() && to_it != to_buses.end()) {
+        
+        if (*from_it == *to_it) {
             
-            return distance_to_stop.at(stop_ptr_pair);
+            if (const auto connection = FindDirectConnection(*from_it, from, to)) {
+                connections.push_back(*connection);
+            }
             
-        } else {
+            ++from_it;
+            ++to_it;
+            
+        } else if (bus_names[*from_it] < bus_names[*to_it]) {
+            ++from_it;
             
-            return 0;
-        } 
+        } else {
+            ++to_it;
+        }
     }
+    
+    return connections;
 }
- 
-size_t TransportCatalogue::GetDistanceToBus(Bus* bus) {
-    size_t distance = 0;
-    auto stops_size = bus->stops.size() - 1;
     
-    for (int i = 0; i < static_cast<int>(stops_size); i++) {
-        distance += GetDistanceStop(bus->stops[i], bus->stops[i+1]);
+std::optional<DirectConnection> TransportCatalogue::FindDirectConnection(BusId bus, StopId from, StopId to) const {
+    const auto stops = GetBusStops(bus);
+    const auto distances = GetBusDistances(bus);
+    
+    std::optional<DirectConnection> best;
+    std::optional<size_t> last_from;
+    
+    // the latest boarding at from before each arrival at to gives the fewest spans for that arrival
+    for (size_t i = 0; i < stops.size(); ++i) {
+        const StopId stop = stops.begin()[i];
+        
+        if (stop == to && last_from) {
+            const uint32_t span_count = static_cast<uint32_t>(i - *last_from);
+            const size_t distance = distances.begin()[i] - distances.begin()[*last_from];
+            
+            if (!best || span_count < best->span_count || (span_count == best->span_count && distance < best->distance)) {
+                best = DirectConnection{bus, span_count, distance};
+            }
+        }
+        
+        if (stop == from) {
+            last_from = i;
+        }
     }
     
-    return distance;
+    return best;
+}
+    
+std::vector<NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates point, size_t count) const {
+    return stop_grid.FindNearest(point, count);
+}
+    
+std::vector<NearbyStop> TransportCatalogue::FindStopsInRadius(geo::Coordinates point, double radius) const {
+    return stop_grid.FindInRadius(point, radius);
+}
+    
+void TransportCatalogue::BuildStopGrid() {
+    stop_grid = StopGrid(stop_coordinates, stop_points);
+}
+    
+void TransportCatalogue::SetStopGrid(const StopGrid::Layout& layout, 
+                                     Table<uint32_t>&& cell_offsets, 
+                                     Table<StopId>&& stop_ids) {
+    
+    stop_grid = StopGrid(layout, std::move(cell_offsets), std::move(stop_ids), stop_points);
+}
+    
+void TransportCatalogue::SetStopGrid(StopGrid&& saved_stop_grid) {
+    stop_grid = std::move(saved_stop_grid);
+}
+    
+const StopGrid& TransportCatalogue::GetStopGrid() const {
+    return stop_grid;
 }
     
 } // namespace transport_catalogue
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <deque>
 #include <string>
 #include <vector>
 #include <iomanip>
@@ -8,58 +7,141 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <numeric>
+#include <optional>
  
+#include "distance_table.h"
 #include "domain.h"
+#include "geo.h"
+#include "name_index.h"
+#include "ranges.h"
+#include "stop_grid.h"
+#include "table.h"
  
 using namespace domain;
  
 namespace transport_catalogue {   
  
-struct DistanceHasher {
-    std::hash<const void*> hasher;
-    
-    std::size_t operator()(const std::pair<const Stop*, const Stop*> pair_stops) const noexcept {
-        auto hash_1 = static_cast<const void*>(pair_stops.first);
-        auto hash_2 = static_cast<const void*>(pair_stops.second);
-        return hasher(hash_1) * 17 + hasher(hash_2);
-    }  
-};
-    
-typedef  std::unordered_map<std::string_view, Stop*> StopMap;
-typedef  std::unordered_map<std::string_view, Bus*> BusMap;
-typedef  std::unordered_map<std::pair<const Stop*, const  Stop*>, int, DistanceHasher> DistanceMap;
+// name hash to ids, finds names until BuildNameIndex; keyed by hash since the NameTable's views move as it grows
+typedef  std::unordered_multimap<size_t, StopId> StopMap;
+typedef  std::unordered_multimap<size_t, BusId> BusMap;
+ 
+typedef  ranges::Range<const StopId*> StopIdRange;
+typedef  ranges::Range<const size_t*> RoadDistanceRange;
+typedef  ranges::Range<const geo::Coordinates*> CoordinatesRange;
+typedef  ranges::Range<DistanceTable::ConstIterator> DistanceRange;
  
 class TransportCatalogue {
 public:      
-    void AddBus(Bus&& bus);
-    void AddStop(Stop&& stop);
+    BusId AddBus(Bus&& bus);
+    StopId AddStop(Stop&& stop);
     void AddDistance(const std::vector<Distance>& distances);
     
-    Bus* GetBus(std::string_view bus_name);
-    Stop* GetStop(std::string_view stop_name);
+    // a saved catalogue restored table by table, the tables may view storage that outlives the catalogue;
+    // points[stop] is geo::ToSpherePoint(coordinates[stop]), bus stop_offsets start with 0
+    void SetStops(NameTable&& names, Table<geo::Coordinates>&& coordinates, Table<geo::SpherePoint>&& points);
+    void SetBuses(NameTable&& names,
+                  Table<uint32_t>&& stop_offsets,
+                  Table<StopId>&& stops,
+                  Table<size_t>&& distances,
+                  Table<uint8_t>&& is_roundtrip,
+                  Table<BusStats>&& stats);
+    void SetDistances(DistanceTable&& distances);
+    // indexes built over the names given to SetStops and SetBuses, in place of BuildNameIndex
+    void SetNameIndex(NameIndex&& stop_index, NameIndex&& bus_index);
+    
+    std::optional<BusId> GetBus(std::string_view bus_name) const;
+    std::optional<StopId> GetStop(std::string_view stop_name) const;
+    
+    size_t GetStopsCount() const;
+    size_t GetBusesCount() const;
+    
+    // views over the catalogue's own storage, indexed by id
+    const NameTable& GetStopNames() const;
+    CoordinatesRange GetStopsCoordinates() const;
+    const Table<geo::SpherePoint>& GetStopPoints() const;
+    const NameTable& GetBusNames() const;
+    
+    std::string_view GetStopName(StopId stop) const;
+    const geo::Coordinates& GetStopCoordinates(StopId stop) const;
+    // deduplicated and sorted by bus name, valid once BuildStopBuses or SetStopBuses has run
+    BusIdRange GetStopBuses(StopId stop) const;
+    
+    std::string_view GetBusName(BusId bus) const;
+    StopIdRange GetBusStops(BusId bus) const;
+    size_t GetBusStopsCount(BusId bus) const;
+    // prefix sums of road distances along the bus' stops, a span distance is a difference of two elements
+    RoadDistanceRange GetBusDistances(BusId bus) const;
+    bool IsRoundtrip(BusId bus) const;
+    size_t GetRouteLength(BusId bus) const;
+    const BusStats& GetBusStats(BusId bus) const;
     
-    std::deque<Stop> GetStops() const;
-    std::deque<Bus> GetBuses() const;
+    std::unordered_set<StopId> GetUniqStops(BusId bus) const;
+    double GetLength(BusId bus) const;
     
-    BusMap GetBusNameToBus() const;
-    StopMap GetStopNameToStop() const;
+    DistanceRange GetDistance() const;
+    const DistanceTable& GetDistanceTable() const;
+    std::optional<int> FindDistance(StopId start, StopId finish) const;
+    size_t GetDistanceStop(StopId start, StopId finish) const;
+    size_t GetDistanceToBus(BusId bus) const;
     
-    std::unordered_set<const Bus*> GetStopUniqBuses(Stop* stop);    
-    std::unordered_set<const Stop*> GetUniqStops(Bus* bus);
-    double GetLength(Bus* bus);
+    BusStats ComputeBusStats(BusId bus) const;
     
-    DistanceMap GetDistance() const;
-    size_t GetDistanceStop(const Stop* start, const Stop* finish) const;
-    size_t GetDistanceToBus(Bus* bus);
+    // freezes the names added so far into perfect hash indexes, later names are still found
+    void BuildNameIndex();
+    
+    // ids ordered by name, valid once BuildNameOrder or SetNameOrder has run
+    const Table<StopId>& GetStopsByName() const;
+    const Table<BusId>& GetBusesByName() const;
+    // names starting with prefix form one run of the name order
+    StopIdRange FindStopsByPrefix(std::string_view prefix) const;
+    BusIdRange FindBusesByPrefix(std::string_view prefix) const;
+    
+    void BuildNameOrder();
+    void SetNameOrder(Table<StopId>&& stops, Table<BusId>&& buses);
+    
+    void BuildStopBuses();
+    void SetStopBuses(Table<uint32_t>&& offsets, Table<BusId>&& bus_ids);
+    const Table<uint32_t>& GetStopBusOffsets() const;
+    const Table<BusId>& GetStopBusIds() const;
+    
+    // buses passing from, then to, in bus name order; each with its fewest spans between the two stops
+    std::vector<DirectConnection> FindDirectConnections(StopId from, StopId to) const;
+    
+    // ordered by distance, valid once BuildStopGrid or SetStopGrid has run
+    std::vector<NearbyStop> FindNearestStops(geo::Coordinates point, size_t count) const;
+    std::vector<NearbyStop> FindStopsInRadius(geo::Coordinates point, double radius) const;
+    
+    void BuildStopGrid();
+    void SetStopGrid(const StopGrid::Layout& layout, Table<uint32_t>&& cell_offsets, Table<StopId>&& stop_ids);
+    void SetStopGrid(StopGrid&& saved_stop_grid);
+    const StopGrid& GetStopGrid() const;
     
 private:    
-    std::deque<Stop> stops;
+    std::optional<DirectConnection> FindDirectConnection(BusId bus, StopId from, StopId to) const;
+    
+    // stop fields, one element per StopId
+    NameTable stop_names;
+    Table<geo::Coordinates> stop_coordinates;
+    Table<geo::SpherePoint> stop_points;
+    Table<uint32_t> stop_bus_offsets;
+    Table<BusId> stop_bus_ids;
+    NameIndex stop_name_index;
     StopMap stopname_to_stop;
+    Table<StopId> stops_by_name;
     
-    std::deque<Bus> buses;
+    // bus fields, one element per BusId; the stop lists of all buses are packed one after another
+    NameTable bus_names;
+    Table<uint32_t> bus_stop_offsets = std::vector<uint32_t>{0};
+    Table<StopId> bus_stops;
+    Table<size_t> bus_distances;
+    Table<uint8_t> bus_is_roundtrip;
+    Table<BusStats> bus_stats;
+    NameIndex bus_name_index;
     BusMap busname_to_bus;
+    Table<BusId> buses_by_name;
     
-    DistanceMap distance_to_stop;
+    DistanceTable distance_to_stop;
+    StopGrid stop_grid;
 };
     
 } // namespace transport_catalogue
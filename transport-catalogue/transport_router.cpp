@@ -7,119 +7,249 @@ namespace router {
 void TransportRouter::SetRoutingSettings(RoutingSettings routing_settings) {
     routing_settings_ = std::move(routing_settings);
 }
-
+ 
 const RoutingSettings& TransportRouter::GetRoutingSettings() const {
     return routing_settings_;
 }
  
 void TransportRouter::BuildRouter(TransportCatalogue& transport_catalogue) {
+    
+    if (routing_settings_.router_engine == RouterEngine::RAPTOR) {
+        SetStops(transport_catalogue.GetStopsCount());
+        raptor_router_ = std::make_unique<RaptorRouter>(transport_catalogue, 
+                                                        routing_settings_.bus_wait_time, 
+                                                        routing_settings_.bus_velocity * KILOMETER / HOUR);
+        return;
+    }
+    
     SetGraph(transport_catalogue);
-    router_ = std::make_unique<Router<double>>(*graph_);
-    router_->Build();
+    BuildRoutingEngine();
+}
+ 
+void TransportRouter::BuildRoutingEngine() {
+    switch (routing_settings_.router_engine) {
+        case RouterEngine::ALL_PAIRS:
+            router_ = std::make_unique<Router<double>>(*graph_, routing_settings_.router_build_threads);
+            break;
+        case RouterEngine::DIJKSTRA:
+            dijkstra_router_ = std::make_unique<DijkstraRouter<double>>(*graph_);
+            break;
+        case RouterEngine::CONTRACTION_HIERARCHIES:
+            contraction_hierarchy_router_ = std::make_unique<ContractionHierarchyRouter<double>>(*graph_);
+            break;
+        case RouterEngine::RAPTOR:
+            throw std::logic_error("raptor engine is built from the catalogue, not from the graph");
+    }
 }
  
 const DirectedWeightedGraph<double>& TransportRouter::GetGraph() const {
     return *graph_;
 }
-
+ 
 const Router<double>& TransportRouter::GetRouter() const {
     return *router_;
 }
-
+ 
+const ContractionHierarchyRouter<double>& TransportRouter::GetContractionHierarchyRouter() const {
+    return *contraction_hierarchy_router_;
+}
+ 
 const std::variant<StopEdge, BusEdge>& TransportRouter::GetEdge(EdgeId id) const {
     return edge_id_to_edge_.at(id);
 }
  
-std::optional<RouterByStop> TransportRouter::GetRouterByStop(Stop* stop) const {
-    if (stop_to_router_.count(stop)) {
-        return stop_to_router_.at(stop);
-    } else {
-        return std::nullopt;
-    }
+const RouterByStop& TransportRouter::GetRouterByStop(StopId stop) const {
+    return stop_to_router_.at(stop);
 }
  
 std::optional<RouteInfo> TransportRouter::GetRouteInfo(VertexId start, graph::VertexId end) const {
-    const auto& route_info = router_->Build_route(start, end);
+    
+    if (routing_settings_.router_engine == RouterEngine::RAPTOR) {
+        return raptor_router_->Build_route(GetStopIndex(start), GetStopIndex(end));
+    }
+    
+    std::optional<Router<double>::RouteInfo> route_info;
+    
+    switch (routing_settings_.router_engine) {
+        case RouterEngine::DIJKSTRA:
+            route_info = dijkstra_router_->Build_route(start, end);
+            break;
+        case RouterEngine::CONTRACTION_HIERARCHIES:
+            route_info = contraction_hierarchy_router_->Build_route(start, end);
+            break;
+        default:
+            route_info = router_->Build_route(start, end);
+            break;
+    }
+    
     if (route_info) {
-        RouteInfo result;
-        result.total_time = route_info->weight;
+        return MakeRouteInfo(*route_info);
+    } else {
+        return std::nullopt;
+    }
+}   
+ 
+std::vector<std::optional<RouteInfo>> TransportRouter::GetRoutesInfo(VertexId start, const std::vector<VertexId>& ends) const {
+    std::vector<std::optional<RouteInfo>> result;
+    result.reserve(ends.size());
+    
+    if (routing_settings_.router_engine == RouterEngine::RAPTOR) {
+        std::vector<StopId> stops_to;
+        stops_to.reserve(ends.size());
         
-        for (const auto edge : route_info->edges) {
-            result.edges.emplace_back(GetEdge(edge));
+        for (const VertexId end : ends) {
+            stops_to.push_back(GetStopIndex(end));
         }
         
-        return result;
+        return raptor_router_->Build_routes(GetStopIndex(start), stops_to);
+        
+    } else if (routing_settings_.router_engine == RouterEngine::DIJKSTRA 
+               || routing_settings_.router_engine == RouterEngine::CONTRACTION_HIERARCHIES) {
+        
+        const auto routes_info = routing_settings_.router_engine == RouterEngine::DIJKSTRA 
+                                 ? dijkstra_router_->Build_routes(start, ends) 
+                                 : contraction_hierarchy_router_->Build_routes(start, ends);
+        
+        for (const auto& route_info : routes_info) {
+            result.push_back(route_info ? std::optional(MakeRouteInfo(*route_info)) : std::nullopt);
+        }
         
     } else {
-        return std::nullopt;
+        
+        for (const VertexId end : ends) {
+            const auto route_info = router_->Build_route(start, end);
+            result.push_back(route_info ? std::optional(MakeRouteInfo(*route_info)) : std::nullopt);
+        }
     }
-}   
     
-const std::unordered_map<Stop*, RouterByStop>& TransportRouter::GetStopToVertex() const {
-    return stop_to_router_;
+    return result;
 }
-
-const std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge>>& TransportRouter::GetEdgeIdToEdge() const {
-    return edge_id_to_edge_;
-}
-    
-std::deque<Stop*> TransportRouter::GetStopsPtr(TransportCatalogue& transport_catalogue) {
-    std::deque<Stop*> stops_ptr;  
+ 
+RouteInfo TransportRouter::MakeRouteInfo(const Router<double>::RouteInfo& route_info) const {
+    RouteInfo result;
+    result.total_time = route_info.weight;
+    result.edges.reserve(route_info.edges.size());
     
-    for (auto [_, stop_ptr] : transport_catalogue.GetStopNameToStop()) {
-        stops_ptr.push_back(stop_ptr);
+    for (const auto edge : route_info.edges) {
+        result.edges.emplace_back(GetEdge(edge));
     }
- 
-    return stops_ptr;
+    
+    return result;
 }
     
-std::deque<Bus*> TransportRouter::GetBusPtr(TransportCatalogue& transport_catalogue) {
-    std::deque<Bus*> buses_ptr;  
+StopId TransportRouter::GetStopIndex(VertexId vertex) {
+    return static_cast<StopId>(vertex / 2);
+}
     
-    for (auto [_, bus_ptr] : transport_catalogue.GetBusNameToBus()) {
-        buses_ptr.push_back(bus_ptr);
-    }
+RouteCache& TransportRouter::GetRouteCache() {
+    return *route_cache_;
+}
+    
+const std::vector<RouterByStop>& TransportRouter::GetStopToVertex() const {
+    return stop_to_router_;
+}
  
-    return buses_ptr;
+const std::vector<std::variant<StopEdge, BusEdge>>& TransportRouter::GetEdgeIdToEdge() const {
+    return edge_id_to_edge_;
 }
     
-void TransportRouter::SetStops(const std::deque<Stop*>& stops) {
-    size_t i = 0;
+void TransportRouter::SetStops(size_t stops_count) {
+    stop_to_router_.clear();
+    stop_to_router_.reserve(stops_count);
     
-    for (const auto stop : stops) {
-        VertexId first = i++;
-        VertexId second = i++;
-        
-        stop_to_router_[stop] = RouterByStop{first, second};
+    for (VertexId i = 0; i < 2 * stops_count; i += 2) {
+        stop_to_router_.push_back(RouterByStop{i, i + 1});
     }
 }
  
-void TransportRouter::AddEdgeToStop() {   
+void TransportRouter::AddEdgeToStop(const TransportCatalogue& transport_catalogue) {   
     
-    for (const auto [stop, num] : stop_to_router_) {
-        EdgeId id = graph_->AddEdge(Edge<double>{num.bus_wait_start, 
-                                                 num.bus_wait_end, 
-                                                 routing_settings_.bus_wait_time});
+    for (StopId stop = 0; stop < stop_to_router_.size(); ++stop) {
+        const RouterByStop& num = stop_to_router_[stop];
+        graph_->AddEdge(Edge<double>{num.bus_wait_start, 
+                                     num.bus_wait_end, 
+                                     routing_settings_.bus_wait_time});
         
-        edge_id_to_edge_[id] = StopEdge{stop->name, routing_settings_.bus_wait_time};
+        edge_id_to_edge_.emplace_back(StopEdge{transport_catalogue.GetStopName(stop), routing_settings_.bus_wait_time});
     }
 }
  
-void TransportRouter::AddEdgeToBus(TransportCatalogue& transport_catalogue) {
+void TransportRouter::AddEdgeToBus(const TransportCatalogue& transport_catalogue) {
  
-    for (auto bus : GetBusPtr(transport_catalogue)) {        
-        ParseBusToEdges(bus->stops.begin(), 
-                           bus->stops.end(), 
-                           transport_catalogue,
-                           bus);
+    // a non-roundtrip bus is stored with its way back, so one pass covers both directions
+    for (BusId bus = 0; bus < transport_catalogue.GetBusesCount(); ++bus) {        
+        ParseBusToEdges(transport_catalogue, bus);
+    }
+}
+        
+void TransportRouter::ParseBusToEdges(const TransportCatalogue& transport_catalogue, BusId bus) {
         
-        if (!bus->is_roundtrip) {
-            ParseBusToEdges(bus->stops.rbegin(),
-                               bus->stops.rend(), 
-                               transport_catalogue,
-                               bus);
+    const std::string_view bus_name = transport_catalogue.GetBusName(bus);
+    const auto stops = transport_catalogue.GetBusStops(bus).begin();
+    const auto distances = transport_catalogue.GetBusDistances(bus).begin();
+    const size_t stops_count = transport_catalogue.GetBusStopsCount(bus);
+    
+    for (size_t from = 0; from < stops_count; ++from) {
+ 
+        for (size_t to = from + 1; to < stops_count; ++to) {
+            EdgeId id = graph_->AddEdge(MakeEdgeToBus(stops[from], stops[to], distances[to] - distances[from]));
+            
+            edge_id_to_edge_.emplace_back(BusEdge{bus_name, to - from, graph_->GetEdge(id).weight});
         }
     }
 }
  
-void TransportRouter::SetGraph
+void TransportRouter::SetGraph(TransportCatalogue& transport_catalogue) {
+    graph_ = std::make_unique<DirectedWeightedGraph<double>>(2 * transport_catalogue.GetStopsCount());
+    
+    SetStops(transport_catalogue.GetStopsCount());
+    AddEdgeToStop(transport_catalogue);
+    AddEdgeToBus(transport_catalogue);
+    FreezeGraph();
+}
+ 
+void TransportRouter::FreezeGraph() {
+    const auto new_edge_ids = graph_->Freeze();
+    
+    std::vector<std::variant<StopEdge, BusEdge>> edge_id_to_edge(edge_id_to_edge_.size());
+    
+    for (EdgeId edge_id = 0; edge_id < edge_id_to_edge_.size(); ++edge_id) {
+        edge_id_to_edge[new_edge_ids[edge_id]] = std::move(edge_id_to_edge_[edge_id]);
+    }
+    
+    edge_id_to_edge_ = std::move(edge_id_to_edge);
+}
+ 
+void TransportRouter::SetGraph(DirectedWeightedGraph<double>&& graph) {
+    graph_ = std::make_unique<DirectedWeightedGraph<double>>(std::move(graph));
+}
+ 
+void TransportRouter::SetRouter(Router<double>::RoutesInternalData&& routes_internal_data) {
+    router_ = std::make_unique<Router<double>>(*graph_, std::move(routes_internal_data));
+}
+ 
+void TransportRouter::SetContractionHierarchy(ContractionHierarchyRouter<double>::HierarchyInternalData&& hierarchy_internal_data) {
+    contraction_hierarchy_router_ = std::make_unique<ContractionHierarchyRouter<double>>(*graph_, std::move(hierarchy_internal_data));
+}
+ 
+void TransportRouter::SetStopToVertex(std::vector<RouterByStop>&& stop_to_router) {
+    stop_to_router_ = std::move(stop_to_router);
+}
+ 
+void TransportRouter::SetEdgeIdToEdge(std::vector<std::variant<StopEdge, BusEdge>>&& edge_id_to_edge) {
+    edge_id_to_edge_ = std::move(edge_id_to_edge);
+}
+ 
+Edge<double> TransportRouter::MakeEdgeToBus(StopId start, StopId end, const double distance) const {
+    Edge<double> result;
+    
+    result.from = stop_to_router_[start].bus_wait_end;
+    result.to = stop_to_router_[end].bus_wait_start;
+    result.weight = distance / (routing_settings_.bus_velocity * KILOMETER / HOUR);
+    
+    return result;
+}
+ 
+} // namespace router
+} // namespace detail
+} // namespace transport_catalogue
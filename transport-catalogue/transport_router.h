@@ -1,12 +1,17 @@
 #pragma once
-
-#include <deque>
-#include <unordered_map>
+ 
+#include <iterator>
+#include <memory>
+#include <stdexcept>
 #include <iostream>
  
 #include "transport_catalogue.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy_router.h"
+#include "raptor_router.h"
 #include "domain.h"
+#include "route_cache.h"
  
 namespace transport_catalogue {
 namespace detail {
@@ -24,65 +29,61 @@ public:
     const RoutingSettings& GetRoutingSettings() const;
  
     void BuildRouter(TransportCatalogue& transport_catalogue);
+    void BuildRoutingEngine();
  
     const DirectedWeightedGraph<double>& GetGraph() const;
     const Router<double>& GetRouter() const;
+    const ContractionHierarchyRouter<double>& GetContractionHierarchyRouter() const;
     const std::variant<StopEdge, BusEdge>& GetEdge(EdgeId id) const;
     
-    std::optional<RouterByStop> GetRouterByStop(Stop* stop) const;
+    const RouterByStop& GetRouterByStop(StopId stop) const;
     std::optional<RouteInfo> GetRouteInfo(VertexId start, VertexId end) const;
+    std::vector<std::optional<RouteInfo>> GetRoutesInfo(VertexId start, const std::vector<VertexId>& ends) const;
+ 
+    // the cache locks itself, so the query threads of a batch share it
+    RouteCache& GetRouteCache();
  
-    const std::unordered_map<Stop*, RouterByStop>& GetStopToVertex() const;
-    const std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge>>& GetEdgeIdToEdge() const;
+    const std::vector<RouterByStop>& GetStopToVertex() const;
+    const std::vector<std::variant<StopEdge, BusEdge>>& GetEdgeIdToEdge() const;
     
-    std::deque<Stop*> GetStopsPtr(TransportCatalogue& transport_catalogue);
-    std::deque<Bus*> GetBusPtr(TransportCatalogue& transport_catalogue);
+    void AddEdgeToStop(const TransportCatalogue& transport_catalogue);
+    void AddEdgeToBus(const TransportCatalogue& transport_catalogue);
         
-    void AddEdgeToStop();
-    void AddEdgeToBus(TransportCatalogue& transport_catalogue);
-    
-    void SetStops(const std::deque<Stop*>& stops);
+    void SetStops(size_t stops_count);
     void SetGraph(TransportCatalogue& transport_catalogue);
+    void FreezeGraph();
+    
+    void SetGraph(DirectedWeightedGraph<double>&& graph);
+    void SetRouter(Router<double>::RoutesInternalData&& routes_internal_data);
+    void SetContractionHierarchy(ContractionHierarchyRouter<double>::HierarchyInternalData&& hierarchy_internal_data);
+    void SetStopToVertex(std::vector<RouterByStop>&& stop_to_router);
+    void SetEdgeIdToEdge(std::vector<std::variant<StopEdge, BusEdge>>&& edge_id_to_edge);
  
-    Edge<double> MakeEdgeToBus(Stop* start, Stop* end, const double distance) const;
+    Edge<double> MakeEdgeToBus(StopId start, StopId end, const double distance) const;
  
-    template <typename Iterator>
-    void ParseBusToEdges(Iterator first, 
-                            Iterator last,
-                            const TransportCatalogue& transport_catalogue, 
-                            const Bus* bus);
+    void ParseBusToEdges(const TransportCatalogue& transport_catalogue, BusId bus);
     
 private:    
-    std::unordered_map<Stop*, RouterByStop> stop_to_router_;
-    std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge>> edge_id_to_edge_;
+    RouteInfo MakeRouteInfo(const Router<double>::RouteInfo& route_info) const;
+    
+    // SetStops gives the stop with id i the vertices 2 * i and 2 * i + 1
+    static StopId GetStopIndex(VertexId vertex);
+    
+    std::vector<RouterByStop> stop_to_router_;
+    // indexed by edge id, the ids stay dense through FreezeGraph
+    std::vector<std::variant<StopEdge, BusEdge>> edge_id_to_edge_;
     
     std::unique_ptr<DirectedWeightedGraph<double>> graph_;
     std::unique_ptr<Router<double>> router_;
+    std::unique_ptr<DijkstraRouter<double>> dijkstra_router_;
+    std::unique_ptr<ContractionHierarchyRouter<double>> contraction_hierarchy_router_;
+    std::unique_ptr<RaptorRouter> raptor_router_;
+    
+    std::unique_ptr<RouteCache> route_cache_ = std::make_unique<RouteCache>();
     
     RoutingSettings routing_settings_;
 };
  
-template <typename Iterator>
-void TransportRouter::ParseBusToEdges(Iterator first, 
-                                         Iterator last,
-                                         const TransportCatalogue& transport_catalogue, 
-                                         const Bus* bus) {
-    
-    for (auto it = first; it != last; ++it) {
-        size_t distance = 0;
-        size_t span = 0;
- 
-        for (auto it2 = std::next(it); it2 != last; ++it2) {
-            distance += transport_catalogue.GetDistanceStop(*prev(it2), *it2);
-            ++span;
- 
-            EdgeId id = graph_->AddEdge(MakeEdgeToBus(*it, *it2, distance));
-            
-            edge_id_to_edge_[id] = BusEdge{bus->name, span, graph_->GetEdge(id).weight};
-        }
-    }
-}
- 
 } // namespace router
 } // namespace detail
 } // namespace transport_catalogue